@@ -29,17 +29,17 @@ using namespace std::string_literals;
 auto handler(int id, TcpSocket sock) -> Task<>
 {
     while (sock) {
-        char buf[1024];
-        auto ec = co_await sock.receive({buf, sizeof(buf)});
-        if (ec > 0) {
-            ec = co_await sock.send({buf, std::size_t(ec)});
+        // the buffer is only borrowed while there is data to echo back
+        auto buf = co_await sock.receiveBuffered();
+        int ec = -1;
+        if (buf) {
+            ec = co_await sock.send(buf.span());
         }
 
-        if (ec == 0) {
-            sock.close();
-        }
-        else if (ec < 0) {
-            std::printf("\t[%d] -> error: %s\n", sock.address().port(), strerror(sock.getLastError()));
+        if (ec < 0) {
+            if (sock.getLastError() != ECONNRESET) {
+                std::printf("\t[%d] -> error: %s\n", sock.address().port(), strerror(sock.getLastError()));
+            }
             sock.close();
         }
     }
@@ -47,8 +47,9 @@ auto handler(int id, TcpSocket sock) -> Task<>
 
 auto dumpFairness() -> Task<>
 {
+    Interval every{5s};
     while (true) {
-        delay(5s);
+        co_await every;
         Scheduler::instance().dumpStats();
     }
 }
@@ -12,14 +12,45 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 #include <chrono>
 
 #include "suil/async/task.hpp"
 
+// resolved records are cached for at least/most this many seconds
+#ifndef SUIL_ASYNC_DNS_MIN_TTL
+#define SUIL_ASYNC_DNS_MIN_TTL 1u
+#endif
+
+#ifndef SUIL_ASYNC_DNS_MAX_TTL
+#define SUIL_ASYNC_DNS_MAX_TTL 3600u
+#endif
+
+// upper bound on how long a name that does not resolve is cached
+#ifndef SUIL_ASYNC_DNS_NEGATIVE_TTL
+#define SUIL_ASYNC_DNS_NEGATIVE_TTL 30u
+#endif
+
+// how long past expiry a cached record is served while it is refreshed
+#ifndef SUIL_ASYNC_DNS_STALE_TTL
+#define SUIL_ASYNC_DNS_STALE_TTL 30u
+#endif
+
+#ifndef SUIL_ASYNC_DNS_CACHE_SIZE
+#define SUIL_ASYNC_DNS_CACHE_SIZE 4096u
+#endif
+
+// timeout of background refreshes of stale records (ms)
+#ifndef SUIL_ASYNC_DNS_REFRESH_TIMEOUT
+#define SUIL_ASYNC_DNS_REFRESH_TIMEOUT 5000u
+#endif
+
 namespace suil {
 
     struct SocketAddress {
         static constexpr int MAX_IP_ADDRESS_SIZE{32u};
+        // large enough for a unix domain socket address (struct sockaddr_un)
+        static constexpr int MAX_ADDRESS_SIZE{112u};
 
         typedef enum {
             IP_ANY,
@@ -38,6 +69,13 @@ namespace suil {
 
         static SocketAddress any(int port, Mode mode = IP_PV4);
         static SocketAddress local(const std::string& name, int port, Mode mode = IP_PV4);
+
+        /**
+         * Create a unix domain socket address
+         * @param path the filesystem path of the socket, a leading '@' creates
+         * an address in the linux abstract namespace
+         */
+        static SocketAddress unixDomain(const std::string& path);
         static JoinableTask<SocketAddress> remote(
                 const std::string& name,
                 int port,
@@ -52,13 +90,39 @@ namespace suil {
             return remote(name, port, IP_PV4, timeout);
         }
 
+        /**
+         * Resolve all the addresses of the given host, ordered by the preferred
+         * address family of \param mode. Answers are cached process wide for the
+         * TTL of the records, concurrent lookups of the same name share a single
+         * query and an expired answer is still served for SUIL_ASYNC_DNS_STALE_TTL
+         * seconds while it is refreshed in the background.
+         */
+        static Task<std::vector<SocketAddress>> remoteAll(
+                const std::string& name,
+                int port,
+                Mode mode = IP_PV4,
+                milliseconds timeout = DELAY_INF);
+
+        /**
+         * Resolve several hosts concurrently, the result holds all the A/AAAA
+         * records of each name in the order of \param names (\see remoteAll)
+         */
+        static Task<std::vector<std::vector<SocketAddress>>> resolveMany(
+                std::vector<std::string> names,
+                int port,
+                Mode mode = IP_PV4,
+                milliseconds timeout = DELAY_INF);
+
     private:
         friend struct TcpListener;
         friend struct TcpSocket;
+        friend class UdpSocket;
+        friend class UnixSocket;
+        friend class UnixListener;
 
         static SocketAddress ipv4FromLiteral(const char *addr, int port);
         static SocketAddress ipv6FromLiteral(const char *addr, int port);
         static SocketAddress ipFromLiteral(const char *addr, int port, suil::SocketAddress::Mode mode);
-        char _data[MAX_IP_ADDRESS_SIZE];
+        alignas(8) char _data[MAX_ADDRESS_SIZE];
     };
 }
\ No newline at end of file
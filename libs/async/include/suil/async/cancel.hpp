@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#pragma once
+
+#include <suil/async/coroutine.hpp>
+
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace suil {
+
+    class CancellationRegistration;
+
+    namespace detail {
+
+        struct cancellation_state {
+            std::mutex lock{};
+            std::atomic_bool cancelled{false};
+            CancellationRegistration *head{nullptr};
+        };
+    }
+
+    /**
+     * A cheap copyable handle used to observe a \see CancellationSource. A
+     * default constructed token is never cancelled.
+     */
+    class CancellationToken {
+    public:
+        CancellationToken() noexcept = default;
+
+        [[nodiscard]] bool isCancelled() const noexcept {
+            return _state != nullptr && _state->cancelled.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]] bool canBeCancelled() const noexcept { return _state != nullptr; }
+
+    private:
+        friend class CancellationSource;
+        friend class CancellationRegistration;
+
+        explicit CancellationToken(std::shared_ptr<detail::cancellation_state> state) noexcept
+            : _state{std::move(state)}
+        {}
+
+        std::shared_ptr<detail::cancellation_state> _state{};
+    };
+
+    /**
+     * Requests cancellation of the operations given one of its tokens. Cancellation
+     * is cooperative, pending waits (fdwait, Delay, AsyncMutex::lockAsync, socket
+     * operations) are abandoned and their coroutines resumed on the thread they were
+     * waiting on with a cancelled status.
+     */
+    class CancellationSource {
+    public:
+        CancellationSource();
+
+        [[nodiscard]] CancellationToken token() const noexcept { return CancellationToken{_state}; }
+
+        [[nodiscard]] bool isCancelled() const noexcept {
+            return _state->cancelled.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Request cancellation, registered callbacks are invoked on the calling thread
+         * before this returns
+         * @return false if cancellation was already requested
+         */
+        bool cancel();
+
+    private:
+        std::shared_ptr<detail::cancellation_state> _state{};
+    };
+
+    /**
+     * Registers a callback to be invoked when a token is cancelled. The callback runs
+     * with the token's lock held, it must not block, resume coroutines inline nor touch
+     * registrations of the same token. Detaching waits for a running callback to return,
+     * after which the callback is guaranteed not to be invoked.
+     */
+    class CancellationRegistration {
+    public:
+        CancellationRegistration() noexcept = default;
+
+        ~CancellationRegistration() noexcept { detach(); }
+
+        DISABLE_COPY(CancellationRegistration);
+        DISABLE_MOVE(CancellationRegistration);
+
+        /**
+         * Attach a callback to the given token. \param arm is invoked with the token's
+         * lock held after the callback is registered, cancellation can therefore not
+         * be observed by the callback before \param arm returns.
+         *
+         * @return false if the token is already cancelled, neither \param callback
+         * nor \param arm are invoked then
+         */
+        template <typename Arm>
+        bool attach(const CancellationToken& token, std::function<void()> callback, Arm&& arm)
+        {
+            SUIL_ASSERT(_state == nullptr);
+            if (!token.canBeCancelled()) {
+                arm();
+                return true;
+            }
+
+            std::lock_guard<std::mutex> lk{token._state->lock};
+            if (token._state->cancelled.load(std::memory_order_relaxed)) {
+                return false;
+            }
+
+            _state = token._state;
+            _callback = std::move(callback);
+            _linked = true;
+            _next = _state->head;
+            if (_next != nullptr) {
+                _next->_prev = this;
+            }
+            _state->head = this;
+            arm();
+            return true;
+        }
+
+        bool attach(const CancellationToken& token, std::function<void()> callback)
+        {
+            return attach(token, std::move(callback), [] {});
+        }
+
+        void detach() noexcept;
+
+    private:
+        friend class CancellationSource;
+        std::shared_ptr<detail::cancellation_state> _state{};
+        CancellationRegistration *_prev{nullptr};
+        CancellationRegistration *_next{nullptr};
+        bool _linked{false};
+        std::function<void()> _callback{};
+    };
+}
@@ -0,0 +1,502 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-24
+ */
+
+#pragma once
+
+#include <suil/async/delay.hpp>
+#include <suil/async/scheduler.hpp>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+
+namespace suil {
+
+    /**
+     * A bounded multi-producer multi-consumer channel. Values are buffered in a
+     * fixed capacity ring, senders wait when it is full and receivers wait when it
+     * is empty. Waiting coroutines are parked on intrusive lists and resumed on the
+     * async thread they were suspended on, not on the thread that woke them up.
+     *
+     * A channel with a capacity of 0 hands values directly from a sender to a receiver.
+     *
+     * Receivers can wait with a timeout, the timer of a waiting receiver is cancelled
+     * with the channel's lock held when it is handed a value.
+     */
+    template <typename T>
+    class Channel {
+        struct waiter {
+            waiter *next{nullptr};
+            std::coroutine_handle<> coro{};
+            uint16 tid{THREAD_ID_ANY};
+            // senders: the value to send, receivers: where to store received values
+            T *items{nullptr};
+            std::optional<T> *single{nullptr};
+            // the number of values transferred
+            std::size_t count{0};
+            // set when the waiter has a timeout, the timer resumes the waiter
+            std::optional<Delay> timer{};
+        };
+
+        struct waiter_list {
+            waiter *head{nullptr};
+            waiter *tail{nullptr};
+
+            void push(waiter *w) noexcept
+            {
+                if (tail == nullptr) {
+                    head = w;
+                }
+                else {
+                    tail->next = w;
+                }
+                tail = w;
+            }
+
+            waiter *pop() noexcept
+            {
+                auto w = head;
+                if (w != nullptr) {
+                    head = w->next;
+                    if (head == nullptr) {
+                        tail = nullptr;
+                    }
+                    w->next = nullptr;
+                }
+                return w;
+            }
+
+            bool empty() const noexcept { return head == nullptr; }
+        };
+
+    public:
+        struct send_operation;
+        struct receive_operation;
+        struct receive_many_operation;
+
+        explicit Channel(std::size_t capacity)
+            : _capacity{capacity}
+        {
+            if (_capacity != 0) {
+                _buffer = std::allocator<T>{}.allocate(_capacity);
+            }
+        }
+
+        ~Channel()
+        {
+            for (; _size != 0; _size--) {
+                std::destroy_at(&_buffer[_head]);
+                _head = (_head + 1) % _capacity;
+            }
+            if (_buffer != nullptr) {
+                std::allocator<T>{}.deallocate(_buffer, _capacity);
+            }
+        }
+
+        DISABLE_COPY(Channel);
+        DISABLE_MOVE(Channel);
+
+        /**
+         * Send a value, waiting for room if the channel is full
+         * @return co_await yields false if the channel is closed
+         */
+        send_operation send(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            return send_operation{*this, std::move(value)};
+        }
+
+        /**
+         * Receive a value, waiting for one if the channel is empty for at most
+         * \param timeout (forever by default)
+         * @return co_await yields std::nullopt once the channel is closed and drained
+         * or when the timeout expires
+         */
+        receive_operation receive(milliseconds timeout = DELAY_INF) noexcept
+        {
+            return receive_operation{*this, timeout};
+        }
+
+        /**
+         * Wait for at least one value, for at most \param timeout, and receive as
+         * many of the available values as fit in \param out
+         * @return co_await yields the number of values received, 0 once the
+         * channel is closed and drained or when the timeout expires
+         */
+        receive_many_operation receiveMany(std::span<T> out, milliseconds timeout = DELAY_INF) noexcept
+        {
+            return receive_many_operation{*this, out, timeout};
+        }
+
+        /**
+         * Send a value without waiting, \param value is only moved from on success
+         * @return false if the channel is full or closed
+         */
+        bool trySend(T&& value)
+        {
+            waiter *wake{nullptr};
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                if (_closed || (_receivers.empty() && _size == _capacity)) {
+                    return false;
+                }
+                wake = put(std::move(value));
+            }
+
+            resume(wake);
+            return true;
+        }
+
+        bool trySend(const T& value)
+        {
+            T copy{value};
+            return trySend(std::move(copy));
+        }
+
+        /**
+         * Receive a value without waiting
+         * @return std::nullopt if the channel is empty
+         */
+        std::optional<T> tryReceive()
+        {
+            std::optional<T> value{};
+            waiter *wake{nullptr};
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                wake = take(value);
+            }
+
+            resume(wake);
+            return value;
+        }
+
+        /**
+         * Close the channel, waiting senders fail and waiting receivers get
+         * nothing. Values still buffered can be received.
+         */
+        void close()
+        {
+            waiter_list senders, receivers;
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                _closed = true;
+                std::swap(senders, _senders);
+                while (auto w = _receivers.pop()) {
+                    if (handoff(w)) {
+                        receivers.push(w);
+                    }
+                }
+            }
+
+            while (auto w = senders.pop()) {
+                resume(w);
+            }
+            while (auto w = receivers.pop()) {
+                resume(w);
+            }
+        }
+
+        bool isClosed() const
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            return _closed;
+        }
+
+        std::size_t size() const
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            return _size;
+        }
+
+        std::size_t capacity() const { return _capacity; }
+
+    private:
+        static void resume(waiter *w)
+        {
+            if (w != nullptr) {
+                // on the thread the waiter was suspended on
+                Scheduler::instance().schedule(w->coro, w->tid);
+            }
+        }
+
+        static void park(waiter& w, std::coroutine_handle<> coro) noexcept
+        {
+            auto id = qid();
+            w.coro = coro;
+            w.tid = id < 0? THREAD_ID_ANY : uint16(id);
+        }
+
+        static void park(waiter& w, std::coroutine_handle<> coro, milliseconds timeout)
+        {
+            // must be called with the lock held, handoff() therefore always finds the timer scheduled
+            park(w, coro);
+            if (timeout.count() >= 0) {
+                w.timer.emplace(timeout.count(), w.tid);
+                w.timer->await_suspend(coro);
+            }
+        }
+
+        static waiter *handoff(waiter *w)
+        {
+            // must be called with the lock held, returns the waiter if it must be resumed
+            if (w->timer) {
+                // has no effect if the timer just expired, the waiter finds out what it got
+                Scheduler::instance().cancel(&*w->timer);
+                return nullptr;
+            }
+            return w;
+        }
+
+        bool unpark(waiter& w)
+        {
+            // must be called by a resumed waiter, returns false if it timed out
+            if (!w.timer) {
+                return true;
+            }
+
+            // a sender may still pop the waiter and cancel its timer, which therefore
+            // must only be released with the lock held
+            std::lock_guard<std::mutex> lk{_lock};
+            w.timer->await_resume();
+            w.timer.reset();
+            if (w.count != 0 || _closed) {
+                return true;
+            }
+
+            // still on the list
+            waiter_list rest{};
+            while (auto it = _receivers.pop()) {
+                if (it != &w) {
+                    rest.push(it);
+                }
+            }
+            std::swap(rest, _receivers);
+            return false;
+        }
+
+        static void deliver(waiter *w, T&& value)
+        {
+            if (w->single != nullptr) {
+                w->single->emplace(std::move(value));
+            }
+            else {
+                w->items[w->count] = std::move(value);
+            }
+            w->count++;
+        }
+
+        void push(T&& value)
+        {
+            std::construct_at(&_buffer[(_head + _size) % _capacity], std::move(value));
+            _size++;
+        }
+
+        T pop()
+        {
+            T value{std::move(_buffer[_head])};
+            std::destroy_at(&_buffer[_head]);
+            _head = (_head + 1) % _capacity;
+            _size--;
+            return value;
+        }
+
+        waiter *put(T&& value)
+        {
+            // must be called with the lock held and room for the value
+            if (auto w = _receivers.pop()) {
+                // receivers only wait on an empty buffer
+                deliver(w, std::move(value));
+                return handoff(w);
+            }
+
+            push(std::move(value));
+            return nullptr;
+        }
+
+        template <typename Out>
+        waiter *take(Out& out)
+        {
+            // must be called with the lock held, returns the sender to wake up if any
+            if (_size != 0) {
+                out = pop();
+                if (auto w = _senders.pop()) {
+                    push(std::move(*w->items));
+                    w->count = 1;
+                    return w;
+                }
+            }
+            else if (auto w = _senders.pop()) {
+                out = std::move(*w->items);
+                w->count = 1;
+                return w;
+            }
+            return nullptr;
+        }
+
+        std::size_t drain(std::span<T> out, waiter_list& wake)
+        {
+            // must be called with the lock held
+            std::size_t count{0};
+            while (count < out.size() && (_size != 0 || !_senders.empty())) {
+                if (auto w = take(out[count])) {
+                    wake.push(w);
+                }
+                count++;
+            }
+            return count;
+        }
+
+        mutable std::mutex _lock{};
+        T *_buffer{nullptr};
+        std::size_t _capacity{0};
+        std::size_t _head{0};
+        std::size_t _size{0};
+        bool _closed{false};
+        waiter_list _senders{};
+        waiter_list _receivers{};
+    };
+
+    template <typename T>
+    struct Channel<T>::send_operation {
+        send_operation(Channel& channel, T&& value) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : _channel{channel},
+              _value{std::move(value)}
+        {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> coro)
+        {
+            waiter *wake{nullptr};
+            {
+                std::lock_guard<std::mutex> lk{_channel._lock};
+                if (_channel._closed) {
+                    return false;
+                }
+
+                if (_channel._receivers.empty() && _channel._size == _channel._capacity) {
+                    park(_waiter, coro);
+                    _waiter.items = &_value;
+                    _channel._senders.push(&_waiter);
+                    return true;
+                }
+
+                wake = _channel.put(std::move(_value));
+                _waiter.count = 1;
+            }
+
+            resume(wake);
+            return false;
+        }
+
+        bool await_resume() const noexcept { return _waiter.count != 0; }
+
+    private:
+        Channel& _channel;
+        T _value;
+        waiter _waiter{};
+    };
+
+    template <typename T>
+    struct Channel<T>::receive_operation {
+        receive_operation(Channel& channel, milliseconds timeout) noexcept
+            : _channel{channel},
+              _timeout{timeout}
+        {}
+
+        bool await_ready() const noexcept { return false; }
+
+        bool await_suspend(std::coroutine_handle<> coro)
+        {
+            waiter *wake{nullptr};
+            {
+                std::lock_guard<std::mutex> lk{_channel._lock};
+                if (_channel._size == 0 && _channel._senders.empty() && !_channel._closed) {
+                    _waiter.single = &_value;
+                    _channel._receivers.push(&_waiter);
+                    park(_waiter, coro, _timeout);
+                    return true;
+                }
+
+                wake = _channel.take(_value);
+            }
+
+            resume(wake);
+            return false;
+        }
+
+        std::optional<T> await_resume() noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            _channel.unpark(_waiter);
+            return std::move(_value);
+        }
+
+    private:
+        Channel& _channel;
+        milliseconds _timeout;
+        std::optional<T> _value{};
+        waiter _waiter{};
+    };
+
+    template <typename T>
+    struct Channel<T>::receive_many_operation {
+        receive_many_operation(Channel& channel, std::span<T> out, milliseconds timeout) noexcept
+            : _channel{channel},
+              _out{out},
+              _timeout{timeout}
+        {}
+
+        bool await_ready() const noexcept { return _out.empty(); }
+
+        bool await_suspend(std::coroutine_handle<> coro)
+        {
+            waiter_list wake{};
+            {
+                std::lock_guard<std::mutex> lk{_channel._lock};
+                _waiter.count = _channel.drain(_out, wake);
+                if (_waiter.count == 0 && !_channel._closed) {
+                    _waiter.items = _out.data();
+                    _channel._receivers.push(&_waiter);
+                    park(_waiter, coro, _timeout);
+                    return true;
+                }
+            }
+
+            while (auto w = wake.pop()) {
+                resume(w);
+            }
+            return false;
+        }
+
+        std::size_t await_resume()
+        {
+            _channel.unpark(_waiter);
+            if (_waiter.items != nullptr && _waiter.count != 0 && _waiter.count < _out.size()) {
+                // woken up with a single value, pick up whatever else is available
+                waiter_list wake{};
+                {
+                    std::lock_guard<std::mutex> lk{_channel._lock};
+                    _waiter.count += _channel.drain(_out.subspan(_waiter.count), wake);
+                }
+
+                while (auto w = wake.pop()) {
+                    resume(w);
+                }
+            }
+            return _waiter.count;
+        }
+
+    private:
+        Channel& _channel;
+        std::span<T> _out;
+        milliseconds _timeout;
+        waiter _waiter{};
+    };
+}
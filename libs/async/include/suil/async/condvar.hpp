@@ -0,0 +1,99 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/mutex.hpp>
+#include <suil/async/task.hpp>
+
+namespace suil {
+
+    /**
+     * A condition variable used along with an \see AsyncMutex. Waiters are pushed
+     * onto a lock-free list, notified waiters are handed over to the mutex and only
+     * resumed once they own it again, notifying never resumes a coroutine inline
+     * and can therefore be done with the mutex held.
+     */
+    class AsyncConditionVariable final {
+    public:
+        struct wait_operation;
+
+        AsyncConditionVariable() noexcept = default;
+
+        ~AsyncConditionVariable();
+
+        DISABLE_COPY(AsyncConditionVariable);
+        DISABLE_MOVE(AsyncConditionVariable);
+
+        /**
+         * Release \param mutex, which must be held by the caller, and wait to be
+         * notified. The mutex is held again when the wait completes.
+         */
+        wait_operation wait(AsyncMutex& mutex) noexcept;
+
+        /**
+         * Wait until \param predicate, evaluated with \param mutex held, returns true
+         */
+        template <typename Predicate>
+        Task<> wait(AsyncMutex& mutex, Predicate predicate)
+        {
+            while (!predicate()) {
+                co_await wait(mutex);
+            }
+        }
+
+        /**
+         * Wake up the longest waiting coroutine if any
+         */
+        void notifyOne() noexcept;
+
+        /**
+         * Wake up all the waiting coroutines
+         */
+        void notifyAll() noexcept;
+
+    private:
+        friend struct wait_operation;
+        void dispatch() noexcept;
+        wait_operation *pop() noexcept;
+
+        // waiters pushed since the last dispatch, most recent first
+        std::atomic<wait_operation *> _newWaiters{nullptr};
+        // waiters in arrival order, only accessed by the dispatching thread
+        wait_operation *_waiters{nullptr};
+        // pending notifications, the thread which increments it from 0 dispatches them
+        std::atomic<uint32> _notifications{0};
+        std::atomic_bool _notifyAll{false};
+    };
+
+    struct AsyncConditionVariable::wait_operation {
+        wait_operation(AsyncConditionVariable& cond, AsyncMutex& mutex) noexcept
+            : _cond{cond},
+              _mutex{mutex},
+              _lock{mutex}
+        {}
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiter) noexcept;
+        void await_resume() const noexcept {}
+
+    private:
+        friend class AsyncConditionVariable;
+        // re-acquire the mutex on behalf of the notified waiter
+        void wake() noexcept;
+
+        AsyncConditionVariable& _cond;
+        AsyncMutex& _mutex;
+        AsyncMutex::lock_operation _lock;
+        wait_operation *_next{nullptr};
+        std::coroutine_handle<> _awaiter{};
+        uint16 _tid{THREAD_ID_ANY};
+    };
+}
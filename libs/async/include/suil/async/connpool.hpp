@@ -0,0 +1,133 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-22
+ */
+
+#pragma once
+
+#include <suil/async/tcp.hpp>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace suil {
+
+    /**
+     * A pool of keep-alive TCP connections keyed by the remote address. Idle
+     * connections are kept on the async thread that released them and are
+     * preferably handed out to coroutines running on that same thread.
+     */
+    class TcpConnectionPool : public std::enable_shared_from_this<TcpConnectionPool> {
+        struct Stats {
+            uint64 created{0};
+            uint64 reused{0};
+            uint64 evicted{0};
+            uint64 broken{0};
+            uint64 timeouts{0};
+        };
+
+    public:
+        sptr(TcpConnectionPool)
+
+        struct Options {
+            // maximum number of idle connections kept per endpoint
+            std::size_t maxIdle{8};
+            // maximum number of idle and checked out connections per endpoint
+            std::size_t maxTotal{64};
+            // idle connections older than this are closed by the evictor
+            milliseconds idleTimeout{30000};
+            // how often the evictor scans for expired idle connections
+            milliseconds evictInterval{5000};
+        };
+
+        DISABLE_COPY(TcpConnectionPool);
+        DISABLE_MOVE(TcpConnectionPool);
+
+        ~TcpConnectionPool() noexcept;
+
+        /**
+         * Create a pool and start its idle connection evictor, which stops
+         * once the pool is released
+         */
+        static Ptr create(Options opts);
+        static Ptr create() { return create(Options{}); }
+
+        /**
+         * Check out a connection to the given address. A healthy idle connection
+         * is reused if there is one, otherwise a new connection is established if
+         * the endpoint is under its maxTotal limit. When it is not, the call waits
+         * for a connection to be released.
+         *
+         * @param addr the remote address to connect to
+         * @param timeout the maximum time to wait for the connection
+         * @return the connection, an invalid socket on failure (see errno)
+         */
+        auto acquire(const SocketAddress& addr, milliseconds timeout = DELAY_INF) -> Task<TcpSocket>;
+
+        /**
+         * Give back a connection checked out with \see acquire
+         * @param sock the connection to return to the pool
+         * @param reusable false if the connection is no longer usable (e.g a
+         * protocol error), the connection is then closed
+         */
+        void release(TcpSocket&& sock, bool reusable = true);
+
+        /**
+         * Close all idle connections, connections that are still checked out
+         * are closed when they are released
+         */
+        void close();
+
+        [[nodiscard]] Stats getStats() const;
+
+    private:
+        struct Waiter {
+            Waiter *next{nullptr};
+            int efd{INVALID_FD};
+            bool granted{false};
+            TcpSocket sock{};
+        };
+
+        struct Idle {
+            TcpSocket sock{};
+            int64 since{0};
+        };
+
+        struct Endpoint {
+            // idle connections per async thread, the last list is used by non-async threads
+            std::vector<std::vector<Idle>> idle{};
+            std::size_t nIdle{0};
+            std::size_t total{0};
+            Waiter *head{nullptr};
+            Waiter *tail{nullptr};
+        };
+
+        explicit TcpConnectionPool(Options opts);
+
+        static VoidTask<> evictor(WPtr pool, milliseconds interval);
+        static std::string key(const SocketAddress& addr);
+        static bool isHealthy(const TcpSocket& sock);
+        static std::size_t localIndex();
+
+        Endpoint& endpoint(const std::string& key);
+        TcpSocket popIdle(Endpoint& ep, std::size_t index);
+        void grant(Endpoint& ep, TcpSocket&& sock);
+        void discard(const std::string& key);
+        void unlink(Endpoint& ep, Waiter *waiter);
+        void evict();
+
+        Options _options{};
+        mutable std::mutex _lock{};
+        std::unordered_map<std::string, Endpoint> _endpoints{};
+        Stats _stats{};
+        bool _closed{false};
+    };
+}
@@ -10,9 +10,12 @@
 
 #pragma once
 
+#include <suil/async/cancel.hpp>
 #include <suil/async/coroutine.hpp>
 #include <suil/async/detail/list.hpp>
 
+#include <bit>
+#include <functional>
 #include <optional>
 #include <set>
 #include <variant>
@@ -20,12 +23,32 @@
 namespace suil {
     struct Event;
     class  Delay;
+    class  Alarm;
+    class  Interval;
 
     struct Timer {
         struct mill_list_item item{};
+        // the absolute deadline in nanoseconds, see afterdns()
         int64_t dd{0};
-        std::variant<std::monostate, Event*, Delay*> target{};
+        // how late, in nanoseconds, the timer may fire
+        int64_t slack{0};
+        std::variant<std::monostate, Event*, Delay*, Alarm*> target{};
+        // whether the timer is on a thread's timer list, guarded by the list's lock
+        bool linked{false};
         inline operator bool() const { return !holds_alternative<std::monostate>(target); }
+
+        /**
+         * @return the time at which the timer fires, the deadline rounded up to the
+         * coarsest power of two nanoseconds within the slack. Timers with nearby
+         * deadlines and similar slack therefore expire together.
+         */
+        [[nodiscard]] int64_t expiry() const {
+            if (slack <= 0 || dd <= 0) {
+                return dd;
+            }
+            auto granularity = int64_t(std::bit_floor(uint64_t(slack)));
+            return (dd + granularity - 1) & ~(granularity - 1);
+        }
     };
 
     class Delay {
@@ -37,7 +60,29 @@ namespace suil {
             tsFIRED
         } State;
 
+        /**
+         * A delay of \param timeout milliseconds
+         */
         Delay(int64_t timeout, uint16_t tid = THREAD_ID_ANY);
+
+        /**
+         * A delay of \param timeout nanoseconds, for waits finer than a millisecond
+         */
+        Delay(nanoseconds timeout, uint16_t tid = THREAD_ID_ANY);
+
+        /**
+         * A delay of \param timeout which may last up to \param slack longer, allowing
+         * the thread to serve nearby timers with a single wakeup
+         */
+        Delay(nanoseconds timeout, nanoseconds slack, uint16_t tid = THREAD_ID_ANY);
+
+        /**
+         * A delay that can be cut short by cancelling \param token, co_await then
+         * yields false as if the delay was abandoned
+         */
+        Delay(int64_t timeout, CancellationToken token, uint16_t tid = THREAD_ID_ANY);
+        Delay(nanoseconds timeout, CancellationToken token, uint16_t tid = THREAD_ID_ANY);
+        Delay(nanoseconds timeout, nanoseconds slack, CancellationToken token, uint16_t tid = THREAD_ID_ANY);
         ~Delay() noexcept;
 
         MOVE_CTOR(Delay) noexcept;
@@ -47,21 +92,166 @@ namespace suil {
 
         bool await_ready() const noexcept { return _state == tsFIRED; }
 
-        void await_suspend(std::coroutine_handle<> coroutine) noexcept;
+        bool await_suspend(std::coroutine_handle<> coroutine) noexcept;
 
-        bool await_resume() noexcept { return _state.exchange(tsCREATED) == tsFIRED; }
+        bool await_resume() noexcept {
+            _registration.detach();
+            return _state.exchange(tsCREATED) == tsFIRED;
+        }
 
     private:
         friend struct Scheduler;
         friend struct Thread;
+        friend class Interval;
         Timer _timer{};
         std::atomic<State> _state{tsCREATED};
         std::coroutine_handle<> _coro{nullptr};
         uint16 _tID{THREAD_ID_ANY};
+        // the thread the delay is scheduled on
+        uint16 _owner{THREAD_ID_ANY};
+        CancellationToken _token{};
+        CancellationRegistration _registration{};
+    };
+
+    /**
+     * A timer which invokes a callback on an async thread when it expires instead
+     * of resuming a coroutine. The callback runs on the thread's event loop and must
+     * therefore not block.
+     */
+    class Alarm {
+    public:
+        explicit Alarm(std::function<void()> callback);
+        ~Alarm() noexcept;
+
+        DISABLE_COPY(Alarm);
+        DISABLE_MOVE(Alarm);
+
+        /**
+         * Arm the alarm to go off at the given deadline (see afterd()), the alarm
+         * can be re-armed from its callback
+         * @return false if the alarm is already armed
+         */
+        bool arm(int64_t dd, uint16_t tid = THREAD_ID_ANY);
+
+        /**
+         * Arm the alarm to go off at the given deadline in nanoseconds (see afterdns())
+         * @return false if the alarm is already armed
+         */
+        bool armns(int64_t dd, uint16_t tid = THREAD_ID_ANY);
+
+        /**
+         * Disarm the alarm, if the alarm already went off this waits for the callback
+         * to return unless called from the callback
+         * @return true if the alarm was armed and will not go off
+         */
+        bool disarm();
+
+        [[nodiscard]] bool isArmed() const { return _armed; }
+        [[nodiscard]] int64_t deadline() const { return _timer.dd / 1000000; }
+        [[nodiscard]] int64_t deadlinens() const { return _timer.dd; }
+
+    private:
+        friend struct Scheduler;
+        friend struct Thread;
+        Timer _timer{};
+        std::atomic_bool _armed{false};
+        std::atomic_bool _running{false};
+        // the thread the alarm was last armed on
+        uint16 _owner{THREAD_ID_ANY};
+        std::function<void()> _callback{};
     };
 
-    inline auto asyncDelay(milliseconds ms) {
-        return Delay{ms.count()};
+    /**
+     * A periodic timer, each co_await suspends until the next tick. The timer is
+     * re-armed in place on every tick instead of registering a new delay.
+     *
+     * @code
+     * Interval every{5s};
+     * while (true) {
+     *     auto ticks = co_await every;
+     *     ...
+     * }
+     * @endcode
+     */
+    class Interval {
+    public:
+        typedef enum {
+            // ticks are spaced by the period from the first tick, the work done
+            // between ticks does not make the interval drift
+            FIXED_RATE,
+            // each tick is one period after the previous tick was awaited again
+            FIXED_DELAY
+        } Mode;
+
+        typedef enum {
+            // ticks missed while the awaiter was busy are coalesced into one tick
+            SKIP,
+            // ticks missed while the awaiter was busy are delivered back to back
+            BURST
+        } MissedTicks;
+
+        /**
+         * An interval ticking every \param period, the first tick is one period
+         * after construction. Missed ticks only apply to \see FIXED_RATE intervals.
+         */
+        Interval(nanoseconds period,
+                 Mode mode = FIXED_RATE,
+                 MissedTicks missed = SKIP,
+                 uint16_t tid = THREAD_ID_ANY);
+
+        /**
+         * An interval that stops when \param token is cancelled, co_await then yields 0
+         */
+        Interval(nanoseconds period,
+                 CancellationToken token,
+                 Mode mode = FIXED_RATE,
+                 MissedTicks missed = SKIP,
+                 uint16_t tid = THREAD_ID_ANY);
+
+        DISABLE_COPY(Interval);
+        DISABLE_MOVE(Interval);
+
+        bool await_ready() noexcept;
+
+        bool await_suspend(std::coroutine_handle<> coroutine) noexcept;
+
+        /**
+         * @return the number of periods that elapsed since the previous tick, more
+         * than 1 if ticks were skipped. 0 if the interval was cancelled
+         */
+        uint64 await_resume() noexcept;
+
+        [[nodiscard]] nanoseconds period() const { return nanoseconds{_period}; }
+
+        /**
+         * @return the deadline in nanoseconds of the next tick (see afterdns())
+         */
+        [[nodiscard]] int64_t next() const { return _next; }
+
+    private:
+        Delay _delay;
+        int64_t _period{0};
+        int64_t _next{0};
+        Mode _mode{FIXED_RATE};
+        MissedTicks _missed{SKIP};
+        bool _due{false};
+        bool _restart{false};
+    };
+
+    inline auto asyncDelay(nanoseconds ns) {
+        return Delay{ns};
+    }
+
+    inline auto asyncDelay(nanoseconds ns, CancellationToken token) {
+        return Delay{ns, std::move(token)};
+    }
+
+    inline auto asyncDelay(nanoseconds ns, nanoseconds slack) {
+        return Delay{ns, slack};
+    }
+
+    inline auto asyncDelay(nanoseconds ns, nanoseconds slack, CancellationToken token) {
+        return Delay{ns, slack, std::move(token)};
     }
 }
 
@@ -0,0 +1,48 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/coroutine.hpp>
+
+#ifndef SUIL_ASYNC_FRAME_POOL_GRANULARITY
+// coroutine frames are pooled in size classes of this many bytes
+#define SUIL_ASYNC_FRAME_POOL_GRANULARITY 64u
+#endif
+
+#ifndef SUIL_ASYNC_FRAME_POOL_MAX_FRAME
+// frames larger than this are always allocated from the heap
+#define SUIL_ASYNC_FRAME_POOL_MAX_FRAME 1024u
+#endif
+
+#ifndef SUIL_ASYNC_FRAME_POOL_CACHED
+// maximum number of free frames kept per size class and thread
+#define SUIL_ASYNC_FRAME_POOL_CACHED 256u
+#endif
+
+namespace suil::detail {
+
+    /**
+     * Thread local free lists of coroutine frames. A frame released on a different
+     * thread than the one it was allocated on is cached by the releasing thread.
+     */
+    struct frame_pool {
+        static void *allocate(std::size_t size);
+        static void deallocate(void *frame, std::size_t size) noexcept;
+    };
+
+    /**
+     * Base of promise types whose coroutine frames are allocated from \see frame_pool
+     */
+    struct pooled_frame {
+        static void *operator new(std::size_t size) { return frame_pool::allocate(size); }
+        static void operator delete(void *frame, std::size_t size) noexcept { frame_pool::deallocate(frame, size); }
+    };
+}
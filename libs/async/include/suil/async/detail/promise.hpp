@@ -6,6 +6,10 @@
 
 #include <suil/async/coroutine.hpp>
 
+#include <exception>
+#include <memory>
+#include <optional>
+
 namespace suil
 {
     namespace detail
@@ -33,32 +37,43 @@ namespace suil
                             ASYNC_LOCATION,
                             tid(),
                             coroutine.address());
-                // After acquiring the flag, the other thread's write to the
-                // coroutine's continuation must be visible (one-way
-                // communication)
-                if (coroutine.promise().flag.exchange(true, std::memory_order_acquire))
+                if constexpr (P::local_v)
                 {
-                    // We're not the first to reach here, meaning the
-                    // continuation is installed properly (if any)
+                    // The awaiter runs on the same thread, it either installed
+                    // its continuation already or finds the task done
+                    coroutine.promise().checkOwner();
                     auto continuation = coroutine.promise().continuation;
-                    if (continuation)
-                    {
-                        ASYNC_TRACEn(3, "[%zu]: resuming continuation %p on %p\n",
-                                 ASYNC_LOCATION,
-                                 tid(),
-                                 continuation.address(),
-                                 coroutine.address());
-                        return continuation;
-                    }
-                    else
+                    return continuation? continuation : std::noop_coroutine();
+                }
+                else
+                {
+                    // After acquiring the flag, the other thread's write to the
+                    // coroutine's continuation must be visible (one-way
+                    // communication)
+                    if (coroutine.promise().flag.exchange(true, std::memory_order_acquire))
                     {
-                        ASYNC_TRACEn(3, "[%zu] coroutine %p, missing continuation",
-                                    ASYNC_LOCATION,
-                                    tid(),
-                                    coroutine.address());
+                        // We're not the first to reach here, meaning the
+                        // continuation is installed properly (if any)
+                        auto continuation = coroutine.promise().continuation;
+                        if (continuation)
+                        {
+                            ASYNC_TRACEn(3, "[%zu]: resuming continuation %p on %p\n",
+                                     ASYNC_LOCATION,
+                                     tid(),
+                                     continuation.address(),
+                                     coroutine.address());
+                            return continuation;
+                        }
+                        else
+                        {
+                            ASYNC_TRACEn(3, "[%zu] coroutine %p, missing continuation",
+                                        ASYNC_LOCATION,
+                                        tid(),
+                                        coroutine.address());
+                        }
                     }
+                    return std::noop_coroutine();
                 }
-                return std::noop_coroutine();
             }
         };
 
@@ -100,15 +115,24 @@ namespace suil
                             next.address(),
                             base.address());
                 base.promise().continuation = next;
-                // The write to the continuation must be visible to a person that
-                // acquires the flag
-                if (base.promise().flag.exchange(true, std::memory_order_release))
+                if constexpr (P::local_v)
                 {
-                    // We're not the first to reach here, meaning the continuation
-                    // won't get read
-                    return next;
+                    // The task can only complete once this thread is suspended
+                    base.promise().checkOwner();
+                    return std::noop_coroutine();
+                }
+                else
+                {
+                    // The write to the continuation must be visible to a person that
+                    // acquires the flag
+                    if (base.promise().flag.exchange(true, std::memory_order_release))
+                    {
+                        // We're not the first to reach here, meaning the continuation
+                        // won't get read
+                        return next;
+                    }
+                    return std::noop_coroutine();
                 }
-                return std::noop_coroutine();
             }
         }
 
@@ -116,10 +140,11 @@ namespace suil
         // coroutine is suspended within another coroutine. The `continuation`
         // handle is used to hop back from that suspension point when the inner
         // coroutine finishes.
-        template <bool Joinable>
+        template <bool Joinable, bool Local = false>
         struct promise_base_t
         {
             constexpr static bool joinable_v = Joinable;
+            constexpr static bool local_v = Local;
 
             // When a coroutine suspends, the continuation stores the handle to the
             // resume point, which immediately following the suspend point.
@@ -141,15 +166,64 @@ namespace suil
 
         // Joinable tasks need an additional semaphore the joiner can wait on
         template <>
-        struct promise_base_t<true> : public promise_base_t<false>
+        struct promise_base_t<true, false> : public promise_base_t<false, false>
         {
             std::binary_semaphore join_sem{0};
         };
 
-        template <typename Task, typename T, bool Joinable>
-        struct promise_t : public promise_base_t<Joinable>
+        // Local tasks and their awaiter never leave the thread the task was
+        // started on, the continuation is installed and read by the same thread
+        // and therefore needs no handshake
+        template <>
+        struct promise_base_t<false, true>
         {
-            T data;
+            constexpr static bool joinable_v = false;
+            constexpr static bool local_v = true;
+
+            std::coroutine_handle<> continuation = nullptr;
+
+#ifndef NDEBUG
+            // The thread the task was started on
+            int16 owner = qid();
+#endif
+
+            std::suspend_never initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception() const noexcept
+            {
+            }
+
+            void checkOwner() const noexcept
+            {
+#ifndef NDEBUG
+                // a local task, or its awaiter, migrated to another thread
+                SUIL_ASSERT(owner == qid());
+#endif
+            }
+        };
+
+        template <typename Task, typename T, bool Joinable, bool Local = false>
+        struct promise_t : public promise_base_t<Joinable, Local>
+        {
+            // The result is constructed in place by co_return and destroyed
+            // along with the frame, T needs not be default constructible
+            union { T data; };
+            bool hasData = false;
+
+            promise_t() noexcept
+            {
+            }
+
+            ~promise_t()
+            {
+                if (hasData)
+                {
+                    std::destroy_at(std::addressof(data));
+                }
+            }
 
             Task get_return_object() noexcept
             {
@@ -158,16 +232,27 @@ namespace suil
                 return {std::coroutine_handle<promise_t>::from_promise(*this)};
             }
 
+            template <typename U = T>
+                requires std::constructible_from<T, U&&>
             void
-            return_value(T const& value) noexcept(std::is_nothrow_copy_assignable_v<T>)
+            return_value(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>)
             {
-                data = value;
+                std::construct_at(std::addressof(data), std::forward<U>(value));
+                hasData = true;
             }
 
-            void
-            return_value(T&& value) noexcept(std::is_nothrow_move_assignable_v<T>)
+            void unhandled_exception() noexcept
             {
-                data = std::move(value);
+                // Exceptions are swallowed, the awaiter gets a default
+                // constructed result where possible
+                if constexpr (std::is_default_constructible_v<T>)
+                {
+                    if (!hasData)
+                    {
+                        std::construct_at(std::addressof(data));
+                        hasData = true;
+                    }
+                }
             }
 
             final_awaiter_t<promise_t, Joinable> final_suspend() noexcept
@@ -176,8 +261,8 @@ namespace suil
             }
         };
 
-        template <typename Task, bool Joinable>
-        struct promise_t<Task, void, Joinable> : public promise_base_t<Joinable>
+        template <typename Task, bool Joinable, bool Local>
+        struct promise_t<Task, void, Joinable, Local> : public promise_base_t<Joinable, Local>
         {
             Task get_return_object() noexcept
             {
@@ -195,5 +280,104 @@ namespace suil
                 return {};
             }
         };
+
+        // Resumes the coroutine awaiting a lazy task by symmetric transfer, the
+        // awaiter is always installed before the task starts running
+        template <typename P>
+        struct lazy_final_awaiter_t
+        {
+            bool await_ready() const noexcept
+            {
+                return false;
+            }
+
+            void await_resume() const noexcept
+            {
+            }
+
+            std::coroutine_handle<>
+            await_suspend(std::coroutine_handle<P> coroutine) const noexcept
+            {
+                auto continuation = coroutine.promise().continuation;
+                return continuation? continuation : std::noop_coroutine();
+            }
+        };
+
+        struct lazy_promise_base_t
+        {
+            std::coroutine_handle<> continuation = nullptr;
+
+            std::exception_ptr error = nullptr;
+
+            // Only start running when awaited
+            std::suspend_always initial_suspend() const noexcept
+            {
+                return {};
+            }
+
+            void unhandled_exception() noexcept
+            {
+                error = std::current_exception();
+            }
+
+            void rethrow() const
+            {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+
+        template <typename Task, typename T>
+        struct lazy_promise_t : public lazy_promise_base_t
+        {
+            std::optional<T> data;
+
+            Task get_return_object() noexcept
+            {
+                return Task{std::coroutine_handle<lazy_promise_t>::from_promise(*this)};
+            }
+
+            template <typename U = T>
+                requires std::convertible_to<U&&, T>
+            void return_value(U&& value) noexcept(std::is_nothrow_constructible_v<T, U&&>)
+            {
+                data.emplace(std::forward<U>(value));
+            }
+
+            lazy_final_awaiter_t<lazy_promise_t> final_suspend() noexcept
+            {
+                return {};
+            }
+
+            T result()
+            {
+                rethrow();
+                return std::move(*data);
+            }
+        };
+
+        template <typename Task>
+        struct lazy_promise_t<Task, void> : public lazy_promise_base_t
+        {
+            Task get_return_object() noexcept
+            {
+                return Task{std::coroutine_handle<lazy_promise_t>::from_promise(*this)};
+            }
+
+            void return_void() noexcept
+            {
+            }
+
+            lazy_final_awaiter_t<lazy_promise_t> final_suspend() noexcept
+            {
+                return {};
+            }
+
+            void result() const
+            {
+                rethrow();
+            }
+        };
     } // namespace detail
 } // namespace coop
\ No newline at end of file
@@ -0,0 +1,106 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-23
+ */
+
+#pragma once
+
+#include <suil/async/cancel.hpp>
+#include <suil/async/task.hpp>
+
+#include <string>
+#include <unordered_map>
+
+#ifndef SUIL_ASYNC_DNS_MAX_PACKET
+// largest UDP answer accepted by the resolver, queries are sent without EDNS
+#define SUIL_ASYNC_DNS_MAX_PACKET 512u
+#endif
+
+#ifndef SUIL_ASYNC_DNS_PORT_QUERIES
+// queries sent from a resolver socket before it is replaced by one bound to a new source port
+#define SUIL_ASYNC_DNS_PORT_QUERIES 64u
+#endif
+
+struct dns_packet;
+
+namespace suil {
+    class Delay;
+}
+
+namespace suil::detail {
+
+    struct resolver_reply {
+        // the answer packet, release with free()
+        struct dns_packet *packet{nullptr};
+        // non-zero if no answer could be obtained
+        int error{0};
+    };
+
+    /**
+     * A stub resolver owned by an async thread. Queries issued on the thread are
+     * multiplexed over a single UDP socket per address family and matched to their
+     * answers by query ID, instead of opening a resolver and socket per query.
+     */
+    class stub_resolver {
+    public:
+        DISABLE_COPY(stub_resolver);
+        DISABLE_MOVE(stub_resolver);
+
+        /**
+         * Query the records of the given type, hopping onto an async thread first
+         * when called from a non-async thread. The hosts file and the search list
+         * of the resolver configuration are honoured.
+         *
+         * @param name the name to resolve
+         * @param type the DNS record type (enum dns_type)
+         * @param deadline the absolute deadline of the query, -1 for none
+         */
+        static auto query(std::string name, int type, int64 deadline) -> Task<resolver_reply>;
+
+    private:
+        struct channel {
+            int fd{INVALID_FD};
+            // queries sent from the socket
+            uint32 sent{0};
+            // queries waiting for an answer on the socket
+            uint32 waiting{0};
+            // the socket is closed once the queries waiting on it are done
+            bool retired{false};
+            CancellationSource stop{};
+        };
+
+        struct pending {
+            // the coroutine waiting for the answer
+            Delay *waiter{nullptr};
+            // the query packet, used to match answers
+            const struct dns_packet *question{nullptr};
+            struct dns_packet *answer{nullptr};
+        };
+
+        explicit stub_resolver(uint16 tid);
+
+        static stub_resolver& local();
+        static auto fallback(std::string name, int type, int64 deadline) -> LazyTask<resolver_reply>;
+
+        auto lookup(std::string name, int type, int64 deadline) -> LazyTask<resolver_reply>;
+        auto exchange(const std::string& qname, int type, int64 deadline) -> LazyTask<resolver_reply>;
+        VoidTask<> reader(channel *chan);
+        channel *open(int family);
+        void release(channel *chan);
+        uint16 nextId();
+        void dispatch(const char *buf, std::size_t len);
+
+        uint16 _tid{0};
+        // the current UDP socket per address family (IPv4, IPv6)
+        channel *_channels[2]{nullptr, nullptr};
+        std::unordered_map<uint16, pending*> _pending{};
+        // query IDs drawn from the kernel's random source in batches
+        uint16 _ids[32]{};
+        std::size_t _nIds{0};
+    };
+}
@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#pragma once
+
+#include <suil/async/delay.hpp>
+
+#include <atomic>
+#include <optional>
+
+namespace suil {
+
+    /**
+     * Wait metrics of the primitives built on \see detail::wait_queue
+     */
+    struct WaitStats {
+        // the number of successful acquisitions
+        uint64 acquired{0};
+        // the number of acquisitions which had to wait
+        uint64 waited{0};
+        // the number of waits which timed out
+        uint64 timedOut{0};
+        // the time spent waiting by acquisitions which had to wait
+        uint64 totalWaitMs{0};
+        uint64 maxWaitMs{0};
+    };
+
+    namespace detail {
+
+        /**
+         * A coroutine parked on a lock-free intrusive list (\see ManualResetEvent),
+         * resumed on the async thread it was suspended on
+         */
+        struct intrusive_waiter {
+            intrusive_waiter *next{nullptr};
+            std::coroutine_handle<> coro{};
+            uint16 tid{THREAD_ID_ANY};
+
+            void park(std::coroutine_handle<> coroutine) noexcept
+            {
+                auto id = qid();
+                coro = coroutine;
+                tid = id < 0? THREAD_ID_ANY : uint16(id);
+            }
+
+            /**
+             * Schedule the waiter on the thread it was suspended on
+             */
+            void resume();
+
+            /**
+             * Push \param w onto the list headed by \param head
+             */
+            static void push(std::atomic<intrusive_waiter *>& head, intrusive_waiter *w) noexcept
+            {
+                auto next = head.load(std::memory_order_relaxed);
+                do {
+                    w->next = next;
+                } while (!head.compare_exchange_weak(next, w, std::memory_order_release, std::memory_order_relaxed));
+            }
+        };
+
+        /**
+         * A coroutine parked on a \see wait_queue, optionally until a deadline
+         */
+        struct timed_waiter {
+            timed_waiter *prev{nullptr};
+            timed_waiter *next{nullptr};
+            std::coroutine_handle<> coro{};
+            uint16 tid{THREAD_ID_ANY};
+            // the number of units (permits, tokens) being waited for
+            uint64 count{0};
+            int64 since{0};
+            bool granted{false};
+            std::optional<Delay> timer{};
+        };
+
+        /**
+         * A FIFO of parked coroutines. The queue is not synchronized, it must be
+         * guarded by the lock of the primitive owning it.
+         */
+        struct wait_queue {
+            void push(timed_waiter *w) noexcept
+            {
+                w->prev = tail;
+                w->next = nullptr;
+                if (tail == nullptr) {
+                    head = w;
+                }
+                else {
+                    tail->next = w;
+                }
+                tail = w;
+                size++;
+            }
+
+            void remove(timed_waiter *w) noexcept
+            {
+                if (w->prev == nullptr) {
+                    head = w->next;
+                }
+                else {
+                    w->prev->next = w->next;
+                }
+                if (w->next == nullptr) {
+                    tail = w->prev;
+                }
+                else {
+                    w->next->prev = w->prev;
+                }
+                w->prev = w->next = nullptr;
+                size--;
+            }
+
+            [[nodiscard]] bool empty() const noexcept { return head == nullptr; }
+
+            /**
+             * Suspend \param coro on \param w until it is granted, or until the
+             * deadline \param dd expires (-1 to wait forever)
+             */
+            void park(timed_waiter& w, std::coroutine_handle<> coro, int64 dd);
+
+            /**
+             * Remove the head waiter and resume it with its request granted
+             */
+            void grant();
+
+            /**
+             * Must be called by the waiter once resumed, the waiter is removed from
+             * the queue if it was not granted
+             * @return true if the waiter was granted
+             */
+            bool resumed(timed_waiter& w);
+
+            timed_waiter *head{nullptr};
+            timed_waiter *tail{nullptr};
+            std::size_t size{0};
+            WaitStats stats{};
+        };
+    }
+}
@@ -17,6 +17,14 @@
 
 #include "suil/async/coroutine.hpp"
 
+#include <span>
+#include <vector>
+
+#ifndef SUIL_ASYNC_ENUMERABLE_CHUNK_SIZE
+// default number of elements buffered by a ChunkedEnumerable before it suspends
+#define SUIL_ASYNC_ENUMERABLE_CHUNK_SIZE 256u
+#endif
+
 namespace suil {
 
     template <typename T>
@@ -76,6 +84,9 @@ namespace suil {
             return Enumerable{std::coroutine_handle<promise_type>::from_promise(*this)};
         }
 
+        auto initial_suspend() const noexcept { return std::suspend_always{}; }
+        auto final_suspend() const noexcept { return std::suspend_always{}; }
+
         void unhandled_exception() noexcept(false) { throw; }
 
         auto yield_value(reference ref) noexcept {
@@ -132,4 +143,249 @@ namespace suil {
     private:
         std::coroutine_handle<promise_type> _coro{};
     };
+
+    /**
+     * A batching variant of \see Enumerable, yielded elements are buffered and the
+     * producer only suspends once a chunk is full (or when it returns). Consumers
+     * either iterate over the chunks as spans or over the individual elements.
+     *
+     * @code
+     *  auto tokens(std::string_view text) -> ChunkedEnumerable<Token> {
+     *      while (!text.empty()) co_yield parse(text);
+     *  }
+     *
+     *  for (auto& token: tokens(text)) {...}
+     *  for (auto chunk: tokens(text).chunkSize(1024).chunks()) {...}
+     * @endcode
+     */
+    template <typename T>
+    struct ChunkedEnumerable {
+        struct promise_type;
+        struct iterator;
+        struct chunk_iterator;
+        struct chunk_range;
+
+        using value_type = T;
+        using reference = value_type&;
+        using pointer = value_type*;
+
+        ChunkedEnumerable() = default;
+        ChunkedEnumerable(std::coroutine_handle<promise_type> co) noexcept
+                : _coro{co}
+        {}
+
+        ChunkedEnumerable(const ChunkedEnumerable&) = delete;
+        ChunkedEnumerable& operator=(const ChunkedEnumerable&) = delete;
+
+        ChunkedEnumerable(ChunkedEnumerable&& o) noexcept
+                : _coro{std::exchange(o._coro, nullptr)}
+        {}
+
+        ChunkedEnumerable& operator=(ChunkedEnumerable&& o) noexcept {
+            if (this != &o) {
+                this->~ChunkedEnumerable();
+                _coro = std::exchange(o._coro, nullptr);
+            }
+            return *this;
+        }
+
+        ~ChunkedEnumerable() noexcept {
+            if (_coro) {
+                _coro.destroy();
+                _coro = nullptr;
+            }
+        }
+
+        /**
+         * Set the number of elements per chunk, must be invoked before iterating
+         */
+        ChunkedEnumerable& chunkSize(std::size_t size) & {
+            SUIL_ASSERT(_coro && size != 0);
+            _coro.promise().reserve(size);
+            return *this;
+        }
+
+        ChunkedEnumerable chunkSize(std::size_t size) && {
+            chunkSize(size);
+            return std::move(*this);
+        }
+
+        iterator begin() noexcept(false) {
+            return iterator{promise_type::fill(_coro)};
+        }
+
+        iterator end() noexcept { return iterator{nullptr}; }
+
+        /**
+         * @return a range over the chunks, each chunk is only valid until the next one
+         * is requested
+         */
+        chunk_range chunks() & noexcept { return chunk_range{{}, _coro}; }
+
+        chunk_range chunks() && noexcept {
+            auto coro = _coro;
+            return chunk_range{std::move(*this), coro};
+        }
+
+    private:
+        std::coroutine_handle<promise_type> _coro{};
+    };
+
+    template <typename T>
+    struct ChunkedEnumerable<T>::promise_type final {
+        friend struct iterator;
+        friend struct chunk_iterator;
+        friend struct chunk_range;
+        friend struct ChunkedEnumerable;
+
+        struct yield_operation {
+            bool await_ready() const noexcept { return !suspend; }
+            void await_suspend(std::coroutine_handle<>) const noexcept {}
+            void await_resume() const noexcept {}
+            bool suspend;
+        };
+
+        promise_type() { reserve(SUIL_ASYNC_ENUMERABLE_CHUNK_SIZE); }
+
+        ChunkedEnumerable get_return_object() noexcept {
+            return ChunkedEnumerable{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        auto initial_suspend() const noexcept { return std::suspend_always{}; }
+        auto final_suspend() const noexcept { return std::suspend_always{}; }
+
+        void unhandled_exception() noexcept(false) { throw; }
+
+        yield_operation yield_value(const value_type& v) {
+            buffer.push_back(v);
+            return yield_operation{buffer.size() == chunkSize};
+        }
+
+        yield_operation yield_value(value_type&& v) {
+            buffer.push_back(std::move(v));
+            return yield_operation{buffer.size() == chunkSize};
+        }
+
+        void return_void() noexcept {}
+
+    private:
+        void reserve(std::size_t size) {
+            chunkSize = size;
+            buffer.reserve(size);
+        }
+
+        /**
+         * Resume the producer for the next chunk
+         * @return the producer handle or nullptr once it is done
+         */
+        static std::coroutine_handle<promise_type> fill(std::coroutine_handle<promise_type> coro) noexcept(false) {
+            if (!coro) {
+                return nullptr;
+            }
+
+            auto& buffer = coro.promise().buffer;
+            buffer.clear();
+            if (!coro.done()) {
+                coro.resume();
+            }
+            return buffer.empty()? nullptr : coro;
+        }
+
+        std::vector<value_type> buffer{};
+        std::size_t chunkSize{0};
+    };
+
+    template <typename T>
+    struct ChunkedEnumerable<T>::iterator final {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type  = T;
+        using reference   = T&;
+        using pointer     = T*;
+
+    public:
+        explicit iterator(std::nullptr_t) noexcept : _coro{nullptr}
+        {}
+        explicit iterator(std::coroutine_handle<promise_type> handle): _coro{handle}
+        {
+            load();
+        }
+
+    public:
+        iterator& operator++(int) = delete;
+
+        iterator& operator++() noexcept(false) {
+            if (++_current == _end) {
+                // one resume per chunk
+                _coro = promise_type::fill(_coro);
+                load();
+            }
+            return *this;
+        }
+
+        pointer operator->() noexcept { return _current; }
+
+        reference operator*() noexcept { return *_current; }
+
+        bool operator==(const iterator& rhs) const noexcept { return _coro == rhs._coro && _current == rhs._current; }
+        bool operator!=(const iterator& rhs) const noexcept { return !(*this == rhs); }
+
+    private:
+        void load() noexcept {
+            if (_coro) {
+                auto& buffer = _coro.promise().buffer;
+                _current = buffer.data();
+                _end = _current + buffer.size();
+            }
+            else {
+                _current = _end = nullptr;
+            }
+        }
+
+        std::coroutine_handle<promise_type> _coro{};
+        pointer _current{nullptr};
+        pointer _end{nullptr};
+    };
+
+    template <typename T>
+    struct ChunkedEnumerable<T>::chunk_iterator final {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using difference_type = std::ptrdiff_t;
+        using value_type  = std::span<T>;
+        using reference   = std::span<T>;
+
+    public:
+        explicit chunk_iterator(std::coroutine_handle<promise_type> handle): _coro{handle}
+        {}
+
+    public:
+        chunk_iterator& operator++(int) = delete;
+
+        chunk_iterator& operator++() noexcept(false) {
+            _coro = promise_type::fill(_coro);
+            return *this;
+        }
+
+        reference operator*() noexcept {
+            return std::span<T>{_coro.promise().buffer};
+        }
+
+        bool operator==(const chunk_iterator& rhs) const noexcept { return this->_coro == rhs._coro; }
+        bool operator!=(const chunk_iterator& rhs) const noexcept { return this->_coro != rhs._coro; }
+
+    private:
+        std::coroutine_handle<promise_type> _coro{};
+    };
+
+    template <typename T>
+    struct ChunkedEnumerable<T>::chunk_range final {
+        chunk_iterator begin() noexcept(false) { return chunk_iterator{promise_type::fill(_coro)}; }
+        chunk_iterator end() noexcept { return chunk_iterator{nullptr}; }
+
+        // owns the producer when the range is taken from a temporary
+        ChunkedEnumerable _owner{};
+        std::coroutine_handle<promise_type> _coro{};
+    };
 }
@@ -20,6 +20,10 @@
 namespace suil {
 
     namespace fdops {
+        /*
+         * These wait for readiness with fdwait and therefore block the async thread
+         * on regular files, which are always reported ready. Use AsyncFile instead.
+         */
         auto read(int fd, std::span<char> buf, std::chrono::milliseconds timeout = DELAY_INF) -> task<int>;
         auto write(int fd, const std::span<const char> &buf, std::chrono::milliseconds timeout = DELAY_INF) -> task<int>;
     }
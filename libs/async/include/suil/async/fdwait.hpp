@@ -25,6 +25,7 @@ namespace suil {
             esSCHEDULED,
             esABANDONED,
             esTIMEOUT,
+            esCANCELLED,
         } State;
 
         typedef enum {
@@ -36,6 +37,8 @@ namespace suil {
             Timer timerHandle;
             int fd{INVALID_FD};
             uint16_t tid{THREAD_ID_ANY};
+            // the thread the event is scheduled on
+            uint16_t owner{THREAD_ID_ANY};
             std::atomic<State> state{esCREATED};
             IO  ion{IN};
             std::coroutine_handle<> coro{nullptr};
@@ -55,16 +58,27 @@ namespace suil {
             return _handle.state == esFIRED;
         }
 
-        void await_suspend(std::coroutine_handle<> coroutine) noexcept;
+        bool await_suspend(std::coroutine_handle<> coroutine) noexcept;
 
         State await_resume() noexcept {
+            _registration.detach();
             _handle.coro = nullptr;
             return _handle.state.exchange(esCREATED);
         }
 
         Event& operator()(int64_t dd) {
             SUIL_ASSERT(_handle.state == esCREATED);
-            _handle.timerHandle.dd = dd;
+            // deadlines are given in milliseconds (see afterd()), timers run in nanoseconds
+            _handle.timerHandle.dd = dd > 0? dd * 1000000 : dd;
+            return Ego;
+        }
+
+        /**
+         * Time out at deadline \param dd or up to \param slack later, see Timer::expiry()
+         */
+        Event& operator()(int64_t dd, milliseconds slack) {
+            Ego(dd);
+            _handle.timerHandle.slack = std::max<int64_t>(nanoseconds{slack}.count(), 0);
             return Ego;
         }
 
@@ -74,12 +88,23 @@ namespace suil {
             return Ego;
         }
 
+        /**
+         * Abandon the wait when \param token is cancelled, co_await then yields esCANCELLED
+         */
+        Event& operator()(CancellationToken token) {
+            SUIL_ASSERT(_handle.state == esCREATED);
+            _token = std::move(token);
+            return Ego;
+        }
+
         [[nodiscard]] uint16 tid() const { return _handle.tid; }
         Handle& handle() { return _handle; }
 
     private:
         friend class Scheduler;
         Handle _handle{};
+        CancellationToken _token{};
+        CancellationRegistration _registration{};
     };
 
     inline auto fdwait(int fd, Event::IO io, int64_t dd = -1, uint16 affinity = THREAD_ID_ANY)
@@ -88,4 +113,18 @@ namespace suil {
         event(io)(dd);
         return event;
     }
+
+    inline auto fdwait(int fd, Event::IO io, int64_t dd, CancellationToken token, uint16 affinity = THREAD_ID_ANY)
+    {
+        Event event(fd, affinity);
+        event(io)(dd)(std::move(token));
+        return event;
+    }
+
+    inline auto fdwait(int fd, Event::IO io, int64_t dd, milliseconds slack, CancellationToken token = {}, uint16 affinity = THREAD_ID_ANY)
+    {
+        Event event(fd, affinity);
+        event(io)(dd, slack)(std::move(token));
+        return event;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,176 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-23
+ */
+
+#pragma once
+
+#include <suil/async/task.hpp>
+
+#include <span>
+#include <string>
+
+#include <sys/types.h>
+
+#ifndef SUIL_ASYNC_FILE_URING
+// set to 0 to always use the I/O thread pool
+#define SUIL_ASYNC_FILE_URING 1
+#endif
+
+#ifndef SUIL_ASYNC_FILE_RING_ENTRIES
+// submission queue size of the io_uring instance owned by each async thread
+#define SUIL_ASYNC_FILE_RING_ENTRIES 256u
+#endif
+
+#ifndef SUIL_ASYNC_FILE_IO_THREADS
+// number of threads serving file I/O when io_uring is not available
+#define SUIL_ASYNC_FILE_IO_THREADS 4u
+#endif
+
+#ifndef SUIL_ASYNC_FILE_ALIGNMENT
+// default alignment of buffers used with O_DIRECT
+#define SUIL_ASYNC_FILE_ALIGNMENT 4096u
+#endif
+
+namespace suil {
+
+    /**
+     * An operation submitted in a batch with \see AsyncFile::submit
+     */
+    struct FileOp {
+        typedef enum : uint8 {
+            READ,
+            WRITE,
+            FSYNC,
+            FDATASYNC,
+            FALLOCATE
+        } Kind;
+
+        Kind op{READ};
+        // the buffer to read into or write from
+        std::span<char> buf{};
+        // the file offset of a read, write or fallocate
+        off_t offset{0};
+        // the number of bytes to allocate with FALLOCATE
+        off_t length{0};
+        // the fallocate mode (e.g FALLOC_FL_KEEP_SIZE)
+        int mode{0};
+        // the number of bytes transferred, 0 for the other operations or -errno on failure
+        int result{0};
+    };
+
+    /**
+     * A buffer suitably aligned for O_DIRECT transfers, both the address and the
+     * size of O_DIRECT buffers must be multiples of the logical block size
+     */
+    class AlignedBuffer {
+    public:
+        AlignedBuffer() noexcept = default;
+
+        /**
+         * @param size the size of the buffer, rounded up to \param alignment
+         * @param alignment the alignment of the buffer, a power of 2
+         */
+        explicit AlignedBuffer(std::size_t size, std::size_t alignment = SUIL_ASYNC_FILE_ALIGNMENT);
+
+        ~AlignedBuffer() noexcept;
+
+        AlignedBuffer(AlignedBuffer&& other) noexcept;
+        AlignedBuffer& operator=(AlignedBuffer&& other) noexcept;
+
+        DISABLE_COPY(AlignedBuffer);
+
+        char *data() { return _data; }
+        const char *data() const { return _data; }
+        std::size_t size() const { return _size; }
+        operator std::span<char>() { return {_data, _size}; }
+        operator bool() const { return _data != nullptr; }
+
+        static std::size_t roundUp(std::size_t n, std::size_t alignment = SUIL_ASYNC_FILE_ALIGNMENT) {
+            return (n + alignment - 1) & ~(alignment - 1);
+        }
+
+    private:
+        char *_data{nullptr};
+        std::size_t _size{0};
+    };
+
+    /**
+     * Asynchronous I/O on regular files and block devices, which are always
+     * reported ready by epoll. Operations are submitted to an io_uring owned
+     * by the calling async thread when the kernel supports it, otherwise they
+     * are executed by a dedicated pool of I/O threads. Either way the calling
+     * coroutine is suspended until the operation completes and the async
+     * thread keeps running other coroutines.
+     */
+    class AsyncFile {
+    public:
+        AsyncFile() noexcept = default;
+
+        explicit AsyncFile(int fd) noexcept
+            : _fd{fd}
+        {}
+
+        ~AsyncFile() noexcept;
+
+        AsyncFile(AsyncFile&& other) noexcept;
+        AsyncFile& operator=(AsyncFile&& other) noexcept;
+
+        DISABLE_COPY(AsyncFile);
+
+        /**
+         * Open a file, the file is opened synchronously (\see open(2))
+         * @return the opened file, an invalid file on failure (see errno)
+         */
+        static AsyncFile open(const std::string& path, int flags, mode_t mode = 0644);
+
+        /**
+         * Read at most buf.size() bytes at the given offset
+         * @return the number of bytes read, -1 on failure (see errno)
+         */
+        auto pread(std::span<char> buf, off_t offset) -> Task<int>;
+
+        /**
+         * Write at most buf.size() bytes at the given offset
+         * @return the number of bytes written, -1 on failure (see errno)
+         */
+        auto pwrite(std::span<const char> buf, off_t offset) -> Task<int>;
+
+        /**
+         * Flush the file to the storage device
+         * @param dataOnly only flush metadata needed to read the data back (fdatasync)
+         */
+        auto fsync(bool dataOnly = false) -> Task<int>;
+
+        /**
+         * Allocate (or with \param mode deallocate) disk space for the given range
+         */
+        auto fallocate(off_t offset, off_t length, int mode = 0) -> Task<int>;
+
+        /**
+         * Submit several operations on this file at once, they are submitted with
+         * a single system call when io_uring is used and may complete in any order.
+         *
+         * @return 0 when all the operations succeeded, -1 otherwise with errno set
+         * to the error of the first failed operation (see FileOp::result)
+         */
+        auto submit(std::span<FileOp> ops) -> Task<int>;
+
+        void close();
+        int fd() const { return _fd; }
+        operator bool() const { return _fd != INVALID_FD; }
+
+        /**
+         * @return true if file operations on the calling thread go through io_uring
+         */
+        static bool hasUring();
+
+    private:
+        int _fd{INVALID_FD};
+    };
+}
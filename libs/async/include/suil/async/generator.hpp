@@ -0,0 +1,354 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/scheduler.hpp>
+
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace suil {
+
+    /**
+     * A lazily started producer of values which, unlike \see Enumerable, can co_await
+     * between the values it yields.
+     *
+     * @code
+     *  auto rows(Connection& conn) -> AsyncGenerator<Row> {
+     *      while (auto page = co_await conn.fetch()) {
+     *          for (auto& row: *page) co_yield std::move(row);
+     *      }
+     *  }
+     *
+     *  auto gen = rows(conn);
+     *  while (true) {
+     *      auto row = co_await gen.next();
+     *      if (!row) break;
+     *      ...
+     *  }
+     * @endcode
+     *
+     * By default the producer only runs while the consumer waits for the next value,
+     * control is transferred symmetrically between the two. With \see prefetch the
+     * producer keeps running, on the thread it was last suspended on, until the given
+     * number of values are buffered ahead of the consumer.
+     */
+    template <typename T>
+    class AsyncGenerator final {
+    public:
+        struct promise_type;
+        struct next_operation;
+        using handle_type = std::coroutine_handle<promise_type>;
+
+        AsyncGenerator() noexcept = default;
+
+        explicit AsyncGenerator(handle_type coro) noexcept
+            : _coro{coro}
+        {}
+
+        AsyncGenerator(AsyncGenerator&& other) noexcept
+            : _coro{std::exchange(other._coro, nullptr)}
+        {}
+
+        AsyncGenerator& operator=(AsyncGenerator&& other) noexcept
+        {
+            if (this != &other) {
+                release();
+                _coro = std::exchange(other._coro, nullptr);
+            }
+            return *this;
+        }
+
+        DISABLE_COPY(AsyncGenerator);
+
+        ~AsyncGenerator() noexcept { release(); }
+
+        /**
+         * Allow the producer to run up to \param count values ahead of the consumer,
+         * must be invoked before the first value is requested
+         */
+        AsyncGenerator& prefetch(std::size_t count)
+        {
+            SUIL_ASSERT(_coro);
+            _coro.promise().setPrefetch(count);
+            return *this;
+        }
+
+        /**
+         * Wait for the next value
+         * @return co_await yields std::nullopt once the producer is done, an exception
+         * thrown by the producer is rethrown once the values it yielded are consumed
+         */
+        next_operation next() noexcept
+        {
+            SUIL_ASSERT(_coro);
+            return next_operation{_coro.promise()};
+        }
+
+    private:
+        void release() noexcept
+        {
+            if (_coro && _coro.promise().abandon()) {
+                _coro.destroy();
+            }
+            _coro = nullptr;
+        }
+
+        handle_type _coro{};
+    };
+
+    template <typename T>
+    struct AsyncGenerator<T>::promise_type final {
+        struct yield_operation {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(handle_type producer) noexcept
+            {
+                return _promise.produced(producer, std::move(_value));
+            }
+
+            void await_resume() const noexcept {}
+
+            promise_type& _promise;
+            T _value;
+        };
+
+        struct final_operation {
+            bool await_ready() const noexcept { return false; }
+
+            std::coroutine_handle<> await_suspend(handle_type producer) noexcept
+            {
+                return producer.promise().finished(producer);
+            }
+
+            void await_resume() const noexcept {}
+        };
+
+        promise_type()
+            : _ring(1)
+        {}
+
+        AsyncGenerator get_return_object() noexcept
+        {
+            return AsyncGenerator{handle_type::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept { return {}; }
+
+        final_operation final_suspend() const noexcept { return {}; }
+
+        yield_operation yield_value(T value) noexcept(std::is_nothrow_move_constructible_v<T>)
+        {
+            return yield_operation{*this, std::move(value)};
+        }
+
+        void return_void() noexcept {}
+
+        void unhandled_exception() noexcept { _error = std::current_exception(); }
+
+    private:
+        friend class AsyncGenerator;
+        friend struct next_operation;
+
+        static uint16 tid() noexcept
+        {
+            auto id = qid();
+            return id < 0? THREAD_ID_ANY : uint16(id);
+        }
+
+        void setPrefetch(std::size_t count)
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            SUIL_ASSERT(!_started);
+            _prefetch = count;
+            _ring.resize(std::max<std::size_t>(count, 1));
+        }
+
+        std::coroutine_handle<> produced(handle_type producer, T&& value) noexcept
+        {
+            std::coroutine_handle<> consumer{};
+            uint16 consumerTid{THREAD_ID_ANY};
+            bool park{false}, abandoned{false};
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                abandoned = _abandoned;
+                if (!abandoned) {
+                    _ring[(_head + _size) % _ring.size()].emplace(std::move(value));
+                    _size++;
+                    consumer = std::exchange(_consumer, nullptr);
+                    consumerTid = _consumerTid;
+                    park = _size == _ring.size();
+                    if (park) {
+                        _parked = true;
+                        _producerTid = tid();
+                    }
+                }
+            }
+
+            if (!consumer && !park) {
+                if (abandoned) {
+                    // the generator was dropped while the producer was running
+                    producer.destroy();
+                    return std::noop_coroutine();
+                }
+                return producer;
+            }
+
+            if (park) {
+                // buffer full, hand over to the consumer if it is waiting
+                return consumer? consumer : std::noop_coroutine();
+            }
+
+            // the producer keeps running ahead of the consumer
+            Scheduler::instance().schedule(consumer, consumerTid);
+            return producer;
+        }
+
+        std::coroutine_handle<> finished(handle_type producer) noexcept
+        {
+            std::coroutine_handle<> consumer{};
+            bool abandoned{false};
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                _done = true;
+                abandoned = _abandoned;
+                consumer = std::exchange(_consumer, nullptr);
+            }
+
+            if (abandoned) {
+                producer.destroy();
+                return std::noop_coroutine();
+            }
+            return consumer? consumer : std::noop_coroutine();
+        }
+
+        bool abandon() noexcept
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            if (_parked || _done) {
+                return true;
+            }
+            // the producer is running, it destroys itself when it next suspends
+            _abandoned = true;
+            return false;
+        }
+
+        handle_type take(std::optional<T>& out)
+        {
+            // must be called with the lock held, returns the producer to restart if any
+            if (_size == 0) {
+                return nullptr;
+            }
+
+            out.emplace(std::move(*_ring[_head]));
+            _ring[_head].reset();
+            _head = (_head + 1) % _ring.size();
+            _size--;
+            if (_parked && _prefetch != 0 && !_done) {
+                _parked = false;
+                return handle_type::from_promise(*this);
+            }
+            return nullptr;
+        }
+
+        void restart(handle_type producer)
+        {
+            if (producer) {
+                Scheduler::instance().schedule(producer, _producerTid);
+            }
+        }
+
+        std::mutex _lock{};
+        std::vector<std::optional<T>> _ring;
+        std::size_t _head{0};
+        std::size_t _size{0};
+        std::size_t _prefetch{0};
+        // the producer is suspended and can only be resumed by the consumer
+        bool _parked{true};
+        bool _started{false};
+        bool _done{false};
+        bool _abandoned{false};
+        uint16 _producerTid{THREAD_ID_ANY};
+        std::coroutine_handle<> _consumer{};
+        uint16 _consumerTid{THREAD_ID_ANY};
+        std::exception_ptr _error{};
+    };
+
+    template <typename T>
+    struct AsyncGenerator<T>::next_operation {
+        explicit next_operation(promise_type& promise) noexcept
+            : _promise{promise}
+        {}
+
+        bool await_ready()
+        {
+            handle_type producer{};
+            {
+                std::lock_guard<std::mutex> lk{_promise._lock};
+                if (_promise._size == 0 && !_promise._done) {
+                    return false;
+                }
+                producer = _promise.take(_value);
+            }
+
+            _promise.restart(producer);
+            return true;
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer)
+        {
+            handle_type producer{};
+            {
+                std::lock_guard<std::mutex> lk{_promise._lock};
+                if (_promise._size == 0 && !_promise._done) {
+                    _promise._consumer = consumer;
+                    _promise._consumerTid = promise_type::tid();
+                    if (!_promise._parked) {
+                        // the producer hands over when it yields or finishes
+                        return std::noop_coroutine();
+                    }
+
+                    _promise._parked = false;
+                    _promise._started = true;
+                    return handle_type::from_promise(_promise);
+                }
+                producer = _promise.take(_value);
+            }
+
+            _promise.restart(producer);
+            return consumer;
+        }
+
+        std::optional<T> await_resume()
+        {
+            if (!_value) {
+                // resumed by the producer
+                handle_type producer{};
+                {
+                    std::lock_guard<std::mutex> lk{_promise._lock};
+                    producer = _promise.take(_value);
+                }
+                _promise.restart(producer);
+            }
+
+            if (!_value && _promise._error) {
+                std::rethrow_exception(std::exchange(_promise._error, nullptr));
+            }
+            return std::move(_value);
+        }
+
+    private:
+        promise_type& _promise;
+        std::optional<T> _value{};
+    };
+}
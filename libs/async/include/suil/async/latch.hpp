@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/detail/waiters.hpp>
+
+#include <functional>
+
+namespace suil {
+
+    /**
+     * A single use countdown, coroutines waiting on the latch are resumed on their
+     * own threads once the count reaches zero.
+     */
+    class AsyncLatch final {
+    public:
+        struct wait_operation;
+
+        explicit AsyncLatch(int64 count) noexcept;
+
+        DISABLE_COPY(AsyncLatch);
+        DISABLE_MOVE(AsyncLatch);
+
+        /**
+         * Decrement the count by \param n, releasing the waiters if it reaches zero
+         */
+        void countDown(int64 n = 1) noexcept;
+
+        /**
+         * @return true if the count has reached zero
+         */
+        [[nodiscard]] bool tryWait() const noexcept;
+
+        /**
+         * Wait for the count to reach zero
+         */
+        wait_operation wait() noexcept;
+
+        wait_operation operator co_await() noexcept;
+
+        /**
+         * Decrement the count by \param n and wait for it to reach zero
+         */
+        wait_operation arriveAndWait(int64 n = 1) noexcept;
+
+    private:
+        friend struct wait_operation;
+        std::atomic<int64> _count;
+        // the waiters while counting down, `this` once released
+        std::atomic<void *> _state{nullptr};
+    };
+
+    struct AsyncLatch::wait_operation {
+        explicit wait_operation(AsyncLatch& latch) noexcept
+            : _latch{latch}
+        {}
+
+        bool await_ready() const noexcept { return _latch.tryWait(); }
+        bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+        void await_resume() const noexcept {}
+
+    private:
+        friend class AsyncLatch;
+        AsyncLatch& _latch;
+        detail::intrusive_waiter _waiter{};
+    };
+
+    /**
+     * A reusable barrier for a fixed number of participants. Each phase completes
+     * when every participant has arrived, the completion function is then invoked
+     * by the last participant to arrive before the others are resumed on their own
+     * threads.
+     */
+    class AsyncBarrier final {
+    public:
+        struct arrive_operation;
+
+        explicit AsyncBarrier(int64 count, std::function<void()> completion = {}) noexcept;
+
+        DISABLE_COPY(AsyncBarrier);
+        DISABLE_MOVE(AsyncBarrier);
+
+        /**
+         * Arrive at the barrier and wait for the current phase to complete
+         */
+        arrive_operation arriveAndWait() noexcept;
+
+        /**
+         * Arrive at the barrier without waiting and leave it, the following phases
+         * expect one participant less
+         */
+        void arriveAndDrop();
+
+        /**
+         * @return the number of completed phases
+         */
+        [[nodiscard]] uint64 phase() const noexcept { return _phase.load(std::memory_order_acquire); }
+
+    private:
+        friend struct arrive_operation;
+        bool arrive(detail::intrusive_waiter *w);
+        void complete(detail::intrusive_waiter *self);
+
+        std::atomic<int64> _expected;
+        std::atomic<int64> _remaining;
+        std::atomic<uint64> _phase{0};
+        std::atomic<detail::intrusive_waiter *> _waiters{nullptr};
+        std::function<void()> _completion{};
+    };
+
+    struct AsyncBarrier::arrive_operation {
+        explicit arrive_operation(AsyncBarrier& barrier) noexcept
+            : _barrier{barrier}
+        {}
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> awaiter);
+        void await_resume() const noexcept {}
+
+    private:
+        AsyncBarrier& _barrier;
+        detail::intrusive_waiter _waiter{};
+    };
+}
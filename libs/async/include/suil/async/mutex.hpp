@@ -11,6 +11,7 @@
 
 #pragma once
 
+#include <suil/async/cancel.hpp>
 #include <suil/async/coroutine.hpp>
 
 #include <atomic>
@@ -23,6 +24,7 @@ namespace suil {
     public:
         struct lock_operation;
         struct scoped_lock_operation;
+        struct cancellable_lock_operation;
 
         AsyncMutex() = default;
 
@@ -33,11 +35,17 @@ namespace suil {
 
         bool tryLock() noexcept;
         lock_operation lockAsync() noexcept;
+        /**
+         * Lock the mutex unless \param token is cancelled before the lock is acquired
+         * @return co_await yields true if the lock was acquired
+         */
+        cancellable_lock_operation lockAsync(CancellationToken token) noexcept;
         scoped_lock_operation scopedLockAsync() noexcept;
         void unlock();
 
     private:
         friend struct lock_operation;
+        lock_operation *next();
         static constexpr std::uintptr_t NOT_LOCKED = 1;
         static constexpr std::uintptr_t LOCKED_NO_WAITERS = 0;
         std::atomic<std::uintptr_t> _state{NOT_LOCKED};
@@ -77,10 +85,12 @@ namespace suil {
 
     protected:
         friend class AsyncMutex;
+        // the coroutine to resume with the lock, nullptr if the waiter gave up
+        std::coroutine_handle<> acquire() noexcept;
         AsyncMutex& _mutex;
-    private:
         lock_operation *_next{nullptr};
         std::coroutine_handle<> _waiter{};
+        bool _cancellable{false};
     };
 
     struct AsyncMutex::scoped_lock_operation final : AsyncMutex::lock_operation {
@@ -91,4 +101,31 @@ namespace suil {
             return AsyncMutexLock{_mutex, std::adopt_lock};
         }
     };
-}
\ No newline at end of file
+
+    struct AsyncMutex::cancellable_lock_operation final {
+        cancellable_lock_operation(AsyncMutex& mutex, CancellationToken token) noexcept
+            : _mutex{mutex},
+              _token{std::move(token)}
+        {}
+
+        ~cancellable_lock_operation() noexcept;
+
+        DISABLE_COPY(cancellable_lock_operation);
+        DISABLE_MOVE(cancellable_lock_operation);
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> awaiter) noexcept;
+        bool await_resume() noexcept;
+
+    private:
+        friend class AsyncMutex;
+        // a cancelled waiter stays on the mutex's list until the mutex is handed over,
+        // it is therefore allocated and shared with the mutex
+        struct waiter;
+        AsyncMutex& _mutex;
+        CancellationToken _token;
+        waiter *_waiter{nullptr};
+        CancellationRegistration _registration{};
+        bool _acquired{false};
+    };
+}
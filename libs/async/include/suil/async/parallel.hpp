@@ -0,0 +1,300 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/scheduler.hpp>
+#include <suil/async/scope.hpp>
+#include <suil/async/task.hpp>
+
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <vector>
+
+namespace suil {
+
+    namespace detail {
+
+        /**
+         * The chunks left to a parallel worker, packed as [lo, hi) into a single word.
+         * The owner takes chunks from the front, idle workers steal the back half.
+         */
+        struct alignas(64) parallel_slot {
+            static uint64 pack(uint32 lo, uint32 hi) noexcept { return (uint64(hi) << 32) | lo; }
+
+            void reset(uint32 lo, uint32 hi) noexcept { span.store(pack(lo, hi), std::memory_order_release); }
+
+            bool pop(uint32& chunk) noexcept
+            {
+                auto current = span.load(std::memory_order_acquire);
+                while (true) {
+                    auto lo = uint32(current), hi = uint32(current >> 32);
+                    if (lo >= hi) {
+                        return false;
+                    }
+                    if (span.compare_exchange_weak(current, pack(lo + 1, hi), std::memory_order_acq_rel)) {
+                        chunk = lo;
+                        return true;
+                    }
+                }
+            }
+
+            bool steal(uint32& from, uint32& to) noexcept
+            {
+                auto current = span.load(std::memory_order_acquire);
+                while (true) {
+                    auto lo = uint32(current), hi = uint32(current >> 32);
+                    if (lo >= hi) {
+                        return false;
+                    }
+                    auto mid = lo + (hi - lo) / 2;
+                    if (span.compare_exchange_weak(current, pack(lo, mid), std::memory_order_acq_rel)) {
+                        from = mid;
+                        to = hi;
+                        return true;
+                    }
+                }
+            }
+
+            std::atomic<uint64> span{0};
+        };
+
+        template <typename Body>
+        struct parallel_state {
+            parallel_state(std::size_t count, std::size_t grain, std::size_t chunks, std::size_t workers, Body& body)
+                : count{count},
+                  grain{grain},
+                  workers{workers},
+                  slots{std::make_unique<parallel_slot[]>(workers)},
+                  remaining{workers + 1},
+                  body{body}
+            {
+                for (std::size_t w = 0; w < workers; w++) {
+                    slots[w].reset(uint32(w * chunks / workers), uint32((w + 1) * chunks / workers));
+                }
+            }
+
+            void execute(uint32 chunk)
+            {
+                if (failed.load(std::memory_order_relaxed)) {
+                    return;
+                }
+
+                try {
+                    auto begin = chunk * grain;
+                    body(std::size_t(chunk), begin, std::min(begin + grain, count));
+                }
+                catch (...) {
+                    if (!failed.exchange(true, std::memory_order_acq_rel)) {
+                        error = std::current_exception();
+                    }
+                }
+            }
+
+            void run(std::size_t self)
+            {
+                uint32 chunk, from, to;
+                while (slots[self].pop(chunk)) {
+                    execute(chunk);
+                }
+
+                for (std::size_t i = 1; i < workers; i++) {
+                    auto& victim = slots[(self + i) % workers];
+                    if (victim.steal(from, to)) {
+                        // stolen chunks can be stolen in turn
+                        slots[self].reset(from, to);
+                        while (slots[self].pop(chunk)) {
+                            execute(chunk);
+                        }
+                        i = 0;
+                    }
+                }
+            }
+
+            void finished() noexcept
+            {
+                if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    Scheduler::instance().schedule(waiter, waiterTid);
+                }
+            }
+
+            auto join() noexcept
+            {
+                struct awaiter {
+                    bool await_ready() const noexcept { return false; }
+
+                    bool await_suspend(std::coroutine_handle<> coroutine) noexcept
+                    {
+                        auto id = qid();
+                        state.waiter = coroutine;
+                        state.waiterTid = id < 0? THREAD_ID_ANY : uint16(id);
+                        return state.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1;
+                    }
+
+                    void await_resume() const noexcept {}
+
+                    parallel_state& state;
+                };
+
+                return awaiter{*this};
+            }
+
+            std::size_t count;
+            std::size_t grain;
+            std::size_t workers;
+            std::unique_ptr<parallel_slot[]> slots;
+            // one per worker plus one for the waiter
+            std::atomic<std::size_t> remaining;
+            std::coroutine_handle<> waiter{};
+            uint16 waiterTid{THREAD_ID_ANY};
+            std::atomic_bool failed{false};
+            std::exception_ptr error{};
+            Body& body;
+        };
+
+        template <typename Body>
+        oneway_task parallel_worker(parallel_state<Body> *state, std::size_t self, uint16 tid)
+        {
+            co_await schedule(tid);
+            state->run(self);
+            // the state must not be touched after this
+            state->finished();
+        }
+
+        /**
+         * Invoke \param body(chunk, begin, end) for every chunk of \param grain indices
+         * in [0, \param count), spreading the chunks across the scheduler threads
+         */
+        template <typename Body>
+        LazyTask<> parallel_run(std::size_t count, std::size_t grain, Body body)
+        {
+            if (count == 0) {
+                co_return;
+            }
+
+            grain = std::max<std::size_t>(grain, 1);
+            auto chunks = (count + grain - 1) / grain;
+            SUIL_ASSERT(chunks <= std::numeric_limits<uint32>::max());
+
+            auto& scheduler = Scheduler::instance();
+            auto workers = std::min<std::size_t>(scheduler.threadCount(), chunks);
+            if (workers <= 1) {
+                for (std::size_t chunk = 0; chunk < chunks; chunk++) {
+                    auto begin = chunk * grain;
+                    body(chunk, begin, std::min(begin + grain, count));
+                }
+                co_return;
+            }
+
+            parallel_state<Body> state{count, grain, chunks, workers, body};
+            // start with the calling thread, which is otherwise idle while waiting
+            auto id = qid();
+            auto first = id < 0? 0u : uint32(id);
+            for (std::size_t w = 0; w < workers; w++) {
+                parallel_worker(&state, w, uint16((first + w) % scheduler.threadCount()));
+            }
+
+            co_await state.join();
+            if (state.error) {
+                std::rethrow_exception(state.error);
+            }
+        }
+    }
+
+    /**
+     * Invoke \param fn(i) for every index in [\param begin, \param end), in chunks of
+     * \param grain indices spread across the scheduler threads. Threads done with
+     * their chunks steal the remaining chunks of the others. The calling coroutine is
+     * suspended, not its thread, which takes part in the work.
+     *
+     * The work starts when the returned task is awaited. The first exception thrown
+     * by \param fn stops the chunks which have not started yet, it is rethrown by
+     * co_await once the running chunks complete.
+     */
+    template <typename Fn> requires std::invocable<Fn&, std::size_t>
+    LazyTask<> parallelFor(std::size_t begin, std::size_t end, std::size_t grain, Fn fn)
+    {
+        co_await detail::parallel_run(end > begin? end - begin : 0, grain,
+            [begin, &fn](std::size_t, std::size_t from, std::size_t to) {
+                for (auto i = from; i < to; i++) {
+                    fn(begin + i);
+                }
+            });
+    }
+
+    /**
+     * Invoke \param fn on every element of \param range, \see parallelFor. The range
+     * must outlive the returned task.
+     */
+    template <std::ranges::random_access_range R, typename Fn>
+        requires std::invocable<Fn&, std::ranges::range_reference_t<R>>
+    LazyTask<> parallelFor(R&& range, std::size_t grain, Fn fn)
+    {
+        auto first = std::ranges::begin(range);
+        co_await detail::parallel_run(std::size_t(std::ranges::size(range)), grain,
+            [first, &fn](std::size_t, std::size_t from, std::size_t to) {
+                for (auto i = from; i < to; i++) {
+                    fn(first[i]);
+                }
+            });
+    }
+
+    /**
+     * Store \param fn(x) for every element x of \param range at the same position
+     * from \param out, \see parallelFor
+     */
+    template <std::ranges::random_access_range R, std::random_access_iterator Out, typename Fn>
+        requires std::invocable<Fn&, std::ranges::range_reference_t<R>>
+    LazyTask<> parallelTransform(R&& range, Out out, std::size_t grain, Fn fn)
+    {
+        auto first = std::ranges::begin(range);
+        co_await detail::parallel_run(std::size_t(std::ranges::size(range)), grain,
+            [first, out, &fn](std::size_t, std::size_t from, std::size_t to) {
+                for (auto i = from; i < to; i++) {
+                    out[i] = fn(first[i]);
+                }
+            });
+    }
+
+    /**
+     * Combine \param map(x) for every element x of \param range with \param reduce,
+     * starting from \param init. Chunks are reduced in parallel and their results
+     * combined in order, \param reduce must therefore be associative but needs not
+     * be commutative.
+     *
+     * @return co_await yields the reduced value
+     */
+    template <std::ranges::random_access_range R, typename T, typename Reduce, typename Map = std::identity>
+        requires std::invocable<Map&, std::ranges::range_reference_t<R>>
+    LazyTask<T> parallelReduce(R&& range, std::size_t grain, T init, Reduce reduce, Map map = {})
+    {
+        auto first = std::ranges::begin(range);
+        auto count = std::size_t(std::ranges::size(range));
+        grain = std::max<std::size_t>(grain, 1);
+        std::vector<std::optional<T>> partials((count + grain - 1) / grain);
+
+        co_await detail::parallel_run(count, grain,
+            [first, &partials, &reduce, &map](std::size_t chunk, std::size_t from, std::size_t to) {
+                T acc = map(first[from]);
+                for (auto i = from + 1; i < to; i++) {
+                    acc = reduce(std::move(acc), map(first[i]));
+                }
+                partials[chunk].emplace(std::move(acc));
+            });
+
+        for (auto& partial: partials) {
+            // every chunk ran, a failed chunk throws out of parallel_run
+            SUIL_ASSERT(partial.has_value());
+            init = reduce(std::move(init), std::move(*partial));
+        }
+        co_return init;
+    }
+}
@@ -0,0 +1,503 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/channel.hpp>
+#include <suil/async/latch.hpp>
+#include <suil/async/scope.hpp>
+#include <suil/async/task.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace suil {
+
+    struct StageOptions {
+        // the number of coroutines running the stage
+        std::size_t parallelism{1};
+        // the capacity of the channel feeding the next stage
+        std::size_t capacity{64};
+        // the threads the stage's coroutines are spread over, any thread if empty
+        std::vector<uint16> threads{};
+    };
+
+    struct StageStats {
+        std::string name{};
+        // items taken from the stage's input
+        uint64 received{0};
+        // items passed to the next stage
+        uint64 emitted{0};
+        // time spent in the stage's function
+        uint64 busyUs{0};
+        // time batch stages spent waiting for items to fill a batch, not part of busyUs
+        uint64 waitUs{0};
+        // items waiting in the stage's input
+        std::size_t queueDepth{0};
+        std::size_t queueCapacity{0};
+        // items received per second since the pipeline was started
+        double throughput{0};
+    };
+
+    namespace detail {
+
+        template <typename R>
+        concept pipeline_awaitable = requires (R r) { r.await_ready(); r.await_resume(); };
+
+        template <typename R>
+        struct pipeline_result { using type = R; };
+
+        template <pipeline_awaitable R>
+        struct pipeline_result<R> { using type = std::remove_cvref_t<decltype(std::declval<R&>().await_resume())>; };
+
+        template <typename Fn, typename In>
+        using pipeline_result_t = typename pipeline_result<std::invoke_result_t<Fn&, In>>::type;
+
+        inline uint64 pipeline_clock() noexcept
+        {
+            return uint64(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        }
+
+        struct pipeline_stage {
+            pipeline_stage(std::string name, StageOptions options)
+                : name{std::move(name)},
+                  options{std::move(options)},
+                  active{this->options.parallelism}
+            {
+                SUIL_ASSERT(this->options.parallelism != 0);
+            }
+
+            virtual ~pipeline_stage() = default;
+
+            virtual void start(AsyncLatch& done) = 0;
+
+            virtual StageStats stats(uint64 elapsedNs) const = 0;
+
+            uint16 placement(std::size_t worker) const noexcept
+            {
+                return options.threads.empty()? THREAD_ID_ANY : options.threads[worker % options.threads.size()];
+            }
+
+            template <typename In>
+            StageStats stats(const Channel<In>& input, uint64 elapsedNs) const
+            {
+                StageStats st{name};
+                st.received = received.load(std::memory_order_relaxed);
+                st.emitted = emitted.load(std::memory_order_relaxed);
+                st.busyUs = busyNs.load(std::memory_order_relaxed) / 1000;
+                st.waitUs = waitNs.load(std::memory_order_relaxed) / 1000;
+                st.queueDepth = input.size();
+                st.queueCapacity = input.capacity();
+                if (elapsedNs != 0) {
+                    st.throughput = double(st.received) * 1e9 / double(elapsedNs);
+                }
+                return st;
+            }
+
+            std::string name;
+            StageOptions options;
+            std::atomic<uint64> received{0};
+            std::atomic<uint64> emitted{0};
+            std::atomic<uint64> busyNs{0};
+            std::atomic<uint64> waitNs{0};
+            // the coroutines still running, the last one closes the stage's output
+            std::atomic<std::size_t> active;
+        };
+
+        template <typename R, typename Fn, typename In>
+        auto pipeline_invoke(Fn& fn, In&& item)
+        {
+            // returns an awaitable yielding the result of fn
+            if constexpr (pipeline_awaitable<R>) {
+                return fn(std::forward<In>(item));
+            }
+            else if constexpr (std::is_void_v<R>) {
+                fn(std::forward<In>(item));
+                return std::suspend_never{};
+            }
+            else {
+                struct ready {
+                    bool await_ready() const noexcept { return true; }
+                    void await_suspend(std::coroutine_handle<>) const noexcept {}
+                    R await_resume() { return std::move(value); }
+                    R value;
+                };
+                return ready{fn(std::forward<In>(item))};
+            }
+        }
+
+        /**
+         * Applies a function to each item, the function may return an awaitable
+         */
+        template <typename In, typename Out, typename Fn>
+        struct map_stage final : pipeline_stage {
+            map_stage(std::string name, StageOptions options, Channel<In>& input, Fn fn)
+                : pipeline_stage{std::move(name), std::move(options)},
+                  input{input},
+                  fn{std::move(fn)},
+                  output{std::make_unique<Channel<Out>>(this->options.capacity)}
+            {}
+
+            void start(AsyncLatch& done) override
+            {
+                for (std::size_t w = 0; w < options.parallelism; w++) {
+                    worker(this, &done, placement(w));
+                }
+            }
+
+            StageStats stats(uint64 elapsedNs) const override
+            {
+                return pipeline_stage::stats(input, elapsedNs);
+            }
+
+            static oneway_task worker(map_stage *stage, AsyncLatch *done, uint16 tid)
+            {
+                using R = std::invoke_result_t<Fn&, In>;
+                co_await schedule(tid);
+
+                while (true) {
+                    auto item = co_await stage->input.receive();
+                    if (!item) {
+                        break;
+                    }
+
+                    stage->received.fetch_add(1, std::memory_order_relaxed);
+                    auto started = pipeline_clock();
+                    Out out = co_await pipeline_invoke<R>(stage->fn, std::move(*item));
+                    stage->busyNs.fetch_add(pipeline_clock() - started, std::memory_order_relaxed);
+
+                    auto sent = co_await stage->output->send(std::move(out));
+                    if (!sent) {
+                        break;
+                    }
+                    stage->emitted.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (stage->active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    stage->output->close();
+                }
+                done->countDown();
+            }
+
+            Channel<In>& input;
+            Fn fn;
+            std::unique_ptr<Channel<Out>> output;
+        };
+
+        /**
+         * The last stage of a pipeline, consumes items without passing anything on
+         */
+        template <typename In, typename Fn>
+        struct sink_stage final : pipeline_stage {
+            sink_stage(std::string name, StageOptions options, Channel<In>& input, Fn fn)
+                : pipeline_stage{std::move(name), std::move(options)},
+                  input{input},
+                  fn{std::move(fn)}
+            {}
+
+            void start(AsyncLatch& done) override
+            {
+                for (std::size_t w = 0; w < options.parallelism; w++) {
+                    worker(this, &done, placement(w));
+                }
+            }
+
+            StageStats stats(uint64 elapsedNs) const override
+            {
+                return pipeline_stage::stats(input, elapsedNs);
+            }
+
+            static oneway_task worker(sink_stage *stage, AsyncLatch *done, uint16 tid)
+            {
+                using R = std::invoke_result_t<Fn&, In>;
+                co_await schedule(tid);
+
+                while (true) {
+                    auto item = co_await stage->input.receive();
+                    if (!item) {
+                        break;
+                    }
+
+                    stage->received.fetch_add(1, std::memory_order_relaxed);
+                    auto started = pipeline_clock();
+                    co_await pipeline_invoke<R>(stage->fn, std::move(*item));
+                    stage->busyNs.fetch_add(pipeline_clock() - started, std::memory_order_relaxed);
+                }
+
+                stage->active.fetch_sub(1, std::memory_order_acq_rel);
+                done->countDown();
+            }
+
+            Channel<In>& input;
+            Fn fn;
+        };
+
+        /**
+         * Groups items into batches of a given size, a batch is passed on early if it
+         * could not be filled within a time window from its first item
+         */
+        template <typename In>
+        struct batch_stage final : pipeline_stage {
+            batch_stage(std::string name, StageOptions options, Channel<In>& input, std::size_t count, milliseconds window)
+                : pipeline_stage{std::move(name), std::move(options)},
+                  input{input},
+                  count{count},
+                  window{window},
+                  output{std::make_unique<Channel<std::vector<In>>>(this->options.capacity)}
+            {
+                SUIL_ASSERT(count != 0);
+            }
+
+            void start(AsyncLatch& done) override
+            {
+                for (std::size_t w = 0; w < options.parallelism; w++) {
+                    worker(this, &done, placement(w));
+                }
+            }
+
+            StageStats stats(uint64 elapsedNs) const override
+            {
+                return pipeline_stage::stats(input, elapsedNs);
+            }
+
+            static oneway_task worker(batch_stage *stage, AsyncLatch *done, uint16 tid)
+            {
+                co_await schedule(tid);
+
+                while (true) {
+                    auto first = co_await stage->input.receive();
+                    if (!first) {
+                        break;
+                    }
+
+                    auto started = pipeline_clock();
+                    uint64 waited{0};
+                    std::vector<In> batch;
+                    batch.reserve(stage->count);
+                    batch.push_back(std::move(*first));
+
+                    auto dd = fastnow() + stage->window.count();
+                    while (batch.size() < stage->count) {
+                        auto left = dd - fastnow();
+                        if (left <= 0) {
+                            break;
+                        }
+                        auto since = pipeline_clock();
+                        auto item = co_await stage->input.receive(milliseconds{left});
+                        waited += pipeline_clock() - since;
+                        if (!item) {
+                            // window expired or input closed
+                            break;
+                        }
+                        batch.push_back(std::move(*item));
+                    }
+
+                    // the time spent waiting within the window is not work done by the stage
+                    stage->received.fetch_add(batch.size(), std::memory_order_relaxed);
+                    stage->waitNs.fetch_add(waited, std::memory_order_relaxed);
+                    stage->busyNs.fetch_add(pipeline_clock() - started - waited, std::memory_order_relaxed);
+                    auto sent = co_await stage->output->send(std::move(batch));
+                    if (!sent) {
+                        break;
+                    }
+                    stage->emitted.fetch_add(1, std::memory_order_relaxed);
+                }
+
+                if (stage->active.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    stage->output->close();
+                }
+                done->countDown();
+            }
+
+            Channel<In>& input;
+            std::size_t count;
+            milliseconds window;
+            std::unique_ptr<Channel<std::vector<In>>> output;
+        };
+
+        struct pipeline_core {
+            std::shared_ptr<void> input{};
+            std::vector<std::unique_ptr<pipeline_stage>> stages{};
+            std::unique_ptr<AsyncLatch> done{};
+            uint64 startedAt{0};
+        };
+    }
+
+    /**
+     * A chain of stages connected by bounded channels. Each stage runs its function on
+     * a configurable number of coroutines, a stage whose output channel is full stops
+     * taking items from its input which eventually blocks the producers feeding the
+     * pipeline.
+     *
+     * @code
+     *  auto pipeline = Pipeline<std::string>{1024}
+     *                      .stage("parse", parse, {.parallelism = 4})
+     *                      .batch("batch", 500, 100ms)
+     *                      .sink("store", store, {.threads = {0}});
+     *  pipeline.start();
+     *  while (auto line = co_await reader.next()) {
+     *      co_await pipeline.send(std::move(*line));
+     *  }
+     *  pipeline.close();
+     *  co_await pipeline.join();
+     * @endcode
+     *
+     * Closing the input drains the pipeline, each stage closes its output once its
+     * input is closed and drained.
+     */
+    template <typename In, typename Out = In>
+    class Pipeline {
+    public:
+        /**
+         * Create a pipeline whose input channel buffers up to \param capacity items
+         */
+        explicit Pipeline(std::size_t capacity = 64) requires std::is_same_v<In, Out>
+            : _core{std::make_unique<detail::pipeline_core>()}
+        {
+            auto input = std::make_shared<Channel<In>>(capacity);
+            _input = input.get();
+            _output = input.get();
+            _core->input = std::move(input);
+        }
+
+        Pipeline(Pipeline&&) noexcept = default;
+        Pipeline& operator=(Pipeline&&) noexcept = default;
+
+        ~Pipeline()
+        {
+            // a started pipeline must be joined before it is destroyed
+            SUIL_ASSERT(!_core || !_core->done || _core->done->tryWait());
+        }
+
+        DISABLE_COPY(Pipeline);
+
+        /**
+         * Append a stage applying \param fn to each item, \param fn may return an
+         * awaitable (e.g a Task) whose result is passed on
+         */
+        template <typename Fn> requires (!std::is_void_v<Out>)
+        auto stage(std::string name, Fn fn, StageOptions options = {}) &&
+        {
+            using R = detail::pipeline_result_t<Fn, Out>;
+            static_assert(!std::is_void_v<R>, "use sink() for stages without a result");
+            auto st = std::make_unique<detail::map_stage<Out, R, Fn>>(
+                    std::move(name), std::move(options), *_output, std::move(fn));
+            auto output = st->output.get();
+            return extend<R>(std::move(st), output);
+        }
+
+        /**
+         * Append a stage grouping items into vectors of \param count items, a batch is
+         * passed on before it is full once \param window elapsed since its first item
+         */
+        auto batch(std::string name, std::size_t count, milliseconds window, StageOptions options = {}) &&
+            requires (!std::is_void_v<Out>)
+        {
+            auto st = std::make_unique<detail::batch_stage<Out>>(
+                    std::move(name), std::move(options), *_output, count, window);
+            auto output = st->output.get();
+            return extend<std::vector<Out>>(std::move(st), output);
+        }
+
+        /**
+         * Append the final stage, consuming items with \param fn
+         */
+        template <typename Fn> requires (!std::is_void_v<Out>)
+        auto sink(std::string name, Fn fn, StageOptions options = {}) &&
+        {
+            auto st = std::make_unique<detail::sink_stage<Out, Fn>>(
+                    std::move(name), std::move(options), *_output, std::move(fn));
+            return extend<void>(std::move(st), nullptr);
+        }
+
+        /**
+         * Start the coroutines of all the stages
+         */
+        void start()
+        {
+            SUIL_ASSERT(!_core->done);
+            std::ptrdiff_t total{0};
+            for (auto& st: _core->stages) {
+                total += std::ptrdiff_t(st->options.parallelism);
+            }
+
+            _core->done = std::make_unique<AsyncLatch>(total);
+            _core->startedAt = detail::pipeline_clock();
+            for (auto& st: _core->stages) {
+                st->start(*_core->done);
+            }
+        }
+
+        /**
+         * Feed an item to the pipeline, waiting for room in its input channel
+         * @return co_await yields false if the pipeline's input is closed
+         */
+        auto send(In item) { return _input->send(std::move(item)); }
+
+        bool trySend(In&& item) { return _input->trySend(std::move(item)); }
+
+        /**
+         * Close the pipeline's input, the items already fed are drained
+         */
+        void close() { _input->close(); }
+
+        /**
+         * Receive an item from the last stage of a pipeline without a sink
+         */
+        auto receive(milliseconds timeout = DELAY_INF) requires (!std::is_void_v<Out>)
+        {
+            return _output->receive(timeout);
+        }
+
+        /**
+         * Wait for all the stages to complete after the input is closed
+         */
+        auto join()
+        {
+            SUIL_ASSERT(_core->done);
+            return _core->done->wait();
+        }
+
+        std::vector<StageStats> stats() const
+        {
+            std::vector<StageStats> out;
+            auto elapsed = _core->startedAt == 0? 0 : detail::pipeline_clock() - _core->startedAt;
+            out.reserve(_core->stages.size());
+            for (auto& st: _core->stages) {
+                out.push_back(st->stats(elapsed));
+            }
+            return out;
+        }
+
+    private:
+        template <typename, typename>
+        friend class Pipeline;
+
+        Pipeline(std::unique_ptr<detail::pipeline_core> core, Channel<In> *input, Channel<Out> *output) noexcept
+            : _core{std::move(core)},
+              _input{input},
+              _output{output}
+        {}
+
+        template <typename Next>
+        Pipeline<In, Next> extend(std::unique_ptr<detail::pipeline_stage> st, Channel<Next> *output)
+        {
+            SUIL_ASSERT(!_core->done);
+            _core->stages.push_back(std::move(st));
+            return Pipeline<In, Next>{std::move(_core), _input, output};
+        }
+
+        std::unique_ptr<detail::pipeline_core> _core{};
+        Channel<In> *_input{nullptr};
+        Channel<Out> *_output{nullptr};
+    };
+}
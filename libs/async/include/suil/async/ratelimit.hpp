@@ -0,0 +1,92 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#pragma once
+
+#include <suil/async/detail/waiters.hpp>
+
+#include <mutex>
+
+namespace suil {
+
+    /**
+     * A token bucket rate limiter. The bucket is refilled lazily from the elapsed
+     * time whenever it is used. Coroutines waiting for tokens are queued in FIFO
+     * order and an \see Alarm is armed for the time at which the head of the queue
+     * can be served, no coroutine polls the bucket.
+     */
+    class AsyncRateLimiter {
+    public:
+        struct acquire_operation;
+
+        /**
+         * @param rate the number of tokens added to the bucket per second
+         * @param burst the capacity of the bucket, which starts full
+         */
+        AsyncRateLimiter(double rate, uint64 burst);
+
+        ~AsyncRateLimiter();
+
+        DISABLE_COPY(AsyncRateLimiter);
+        DISABLE_MOVE(AsyncRateLimiter);
+
+        /**
+         * Take \param n tokens without waiting
+         * @return false if the tokens are not available
+         */
+        bool tryAcquire(uint64 n = 1);
+
+        /**
+         * Take \param n tokens, waiting at most \param timeout for them
+         * @return co_await yields false if the wait timed out or if \param n
+         * exceeds the capacity of the bucket
+         */
+        acquire_operation acquire(uint64 n = 1, milliseconds timeout = DELAY_INF) noexcept;
+
+        [[nodiscard]] double available();
+        [[nodiscard]] std::size_t waiting() const;
+        [[nodiscard]] WaitStats getStats() const;
+
+    private:
+        friend struct acquire_operation;
+        void refill(int64 now);
+        bool take(uint64 n, int64 now);
+        void dispatch();
+        mutable std::mutex _lock{};
+        double _rate{0};
+        double _burst{0};
+        double _tokens{0};
+        int64 _refilled{0};
+        uint64 _acquired{0};
+        detail::wait_queue _waiters{};
+        // must be the last member, it is disarmed before the rest is destroyed
+        Alarm _alarm;
+    };
+
+    struct AsyncRateLimiter::acquire_operation {
+        acquire_operation(AsyncRateLimiter& limiter, uint64 n, int64 dd) noexcept
+            : _limiter{limiter},
+              _dd{dd}
+        {
+            _waiter.count = n;
+        }
+
+        bool await_ready() const noexcept { return false; }
+        bool await_suspend(std::coroutine_handle<> coroutine);
+        bool await_resume();
+
+    private:
+        AsyncRateLimiter& _limiter;
+        int64 _dd{-1};
+        bool _acquired{false};
+        bool _suspended{false};
+        detail::timed_waiter _waiter{};
+    };
+}
@@ -0,0 +1,115 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-20
+ */
+
+#pragma once
+
+#include <suil/async/coroutine.hpp>
+
+#include <atomic>
+#include <span>
+#include <vector>
+
+#ifndef SUIL_ASYNC_RECV_BUFFER_SIZE
+#define SUIL_ASYNC_RECV_BUFFER_SIZE 16384u
+#endif
+
+#ifndef SUIL_ASYNC_RECV_BUFFER_SLAB
+#define SUIL_ASYNC_RECV_BUFFER_SLAB 16u
+#endif
+
+namespace suil {
+
+    class RecvBufferPool;
+
+    namespace detail {
+        struct recv_block {
+            RecvBufferPool *owner{nullptr};
+            recv_block *next{nullptr};
+            alignas(std::max_align_t) char data[SUIL_ASYNC_RECV_BUFFER_SIZE];
+        };
+    }
+
+    /**
+     * A receive buffer borrowed from the pool of the async thread on which
+     * data was received. The buffer is returned to its pool when the lease
+     * is released or destroyed, from whichever thread that happens on.
+     */
+    class RecvBuffer {
+    public:
+        RecvBuffer() noexcept = default;
+
+        RecvBuffer(RecvBuffer&& other) noexcept;
+        RecvBuffer& operator=(RecvBuffer&& other) noexcept;
+
+        DISABLE_COPY(RecvBuffer);
+
+        ~RecvBuffer() noexcept { release(); }
+
+        char *data() noexcept { return _block? _block->data : nullptr; }
+        const char *data() const noexcept { return _block? _block->data : nullptr; }
+        std::size_t size() const noexcept { return _size; }
+        static constexpr std::size_t capacity() noexcept { return SUIL_ASYNC_RECV_BUFFER_SIZE; }
+
+        std::span<const char> span() const noexcept { return {data(), _size}; }
+
+        operator bool() const noexcept { return _block != nullptr; }
+
+        void release() noexcept;
+
+    private:
+        friend class RecvBufferPool;
+        friend class Socket;
+
+        explicit RecvBuffer(detail::recv_block *block) noexcept
+            : _block{block}
+        {}
+
+        detail::recv_block *_block{nullptr};
+        std::size_t _size{0};
+    };
+
+    /**
+     * A per-thread slab of receive buffers. Connections only borrow a buffer
+     * once their file descriptor is readable, so the memory held by the pool
+     * is bounded by the number of reads in flight on the thread rather than
+     * by the number of open (and mostly idle) connections.
+     */
+    class RecvBufferPool {
+        struct Stats {
+            uint64 slabs{0};
+            uint64 borrowed{0};
+        };
+    public:
+        DISABLE_COPY(RecvBufferPool);
+        DISABLE_MOVE(RecvBufferPool);
+
+        /**
+         * @return the pool of the calling thread, pools are never destroyed as
+         * buffers borrowed on a thread can be released after it exits
+         */
+        static RecvBufferPool& local();
+
+        RecvBuffer borrow();
+
+        [[nodiscard]] Stats getStats() const;
+
+    private:
+        friend class RecvBuffer;
+        RecvBufferPool() = default;
+        void giveBack(detail::recv_block *block) noexcept;
+        void refill();
+
+        detail::recv_block *_free{nullptr};
+        std::atomic<detail::recv_block*> _remoteFree{nullptr};
+        std::vector<void *> _slabs{};
+        std::atomic<uint64> _slabCount{0};
+        std::atomic<uint64> _borrowed{0};
+    };
+}
@@ -36,6 +36,26 @@ namespace suil {
         void schedule(std::coroutine_handle<> coro, uint16 tid = THREAD_ID_ANY);
         void schedule(Event *event, uint16 tid = THREAD_ID_ANY);
         void schedule(Delay *timer, uint16 tid = THREAD_ID_ANY);
+        void schedule(Alarm *alarm, uint16 tid = THREAD_ID_ANY);
+        /**
+         * Cancel a delay that was scheduled on a specific thread before it expires,
+         * the waiting coroutine is resumed inline and its co_await yields false.
+         * Must be called from the thread the delay is scheduled on.
+         */
+        void unschedule(Delay *timer);
+        /**
+         * Cancel a scheduled event or delay from any thread. The registration is removed
+         * from the owning thread's epoll set and timer list and the waiting coroutine is
+         * scheduled on that thread, the event yields esCANCELLED and the delay false.
+         * Has no effect if the event or delay already fired.
+         */
+        void cancel(Event *event);
+        void cancel(Delay *timer);
+        /**
+         * Remove an armed alarm from its thread's timer list
+         * @return false if the alarm is not armed (e.g it already went off)
+         */
+        bool cancel(Alarm *alarm);
         uint16 threadCount() { return _threadCount; }
         void dumpStats();
         ~Scheduler();
@@ -27,10 +27,13 @@
 
 
 #include <suil/async/coroutine.hpp>
+#include <suil/async/detail/frame_pool.hpp>
+#include <suil/async/detail/waiters.hpp>
 
 #include <atomic>
 #include <cassert>
 #include <exception>
+#include <mutex>
 
 namespace suil {
     namespace detail {
@@ -120,6 +123,21 @@ namespace suil {
             int _uncaughtExceptionCount{0};
             bool _cancelled{false};
         };
+
+        /**
+         * A detached coroutine started by the async scopes, its frame is pooled
+         */
+        struct oneway_task {
+
+            struct promise_type : pooled_frame {
+
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void unhandled_exception() { std::terminate(); }
+                oneway_task get_return_object() { return {}; }
+                void return_void() {}
+            };
+        };
     }
 
     template <typename F>
@@ -152,7 +170,7 @@ namespace suil {
         template<typename Awaitable>
         void spawn(Awaitable&& awaitable)
         {
-            [](AsyncScope* scope, std::decay_t<Awaitable> awaitable) -> oneway_task
+            [](AsyncScope* scope, std::decay_t<Awaitable> awaitable) -> detail::oneway_task
             {
                 scope->on_work_started();
                 auto decrementOnCompletion = onScopeExit([scope] { scope->on_work_finished(); });
@@ -199,20 +217,197 @@ namespace suil {
             _count.fetch_add(1, std::memory_order_relaxed);
         }
 
-        struct oneway_task {
+        std::atomic<size_t> _count{0};
+        std::coroutine_handle<> _continuation{nullptr};
+    };
 
-            struct promise_type {
+    /**
+     * An \see AsyncScope which runs at most a given number of spawned awaitables at
+     * a time. Spawning is awaitable, the spawner is suspended while the limit is
+     * reached and resumed on its own thread once one of the running awaitables
+     * completes.
+     *
+     * @code
+     *  BoundedAsyncScope scope{64};
+     *  while (auto record = co_await source.receive()) {
+     *      co_await scope.spawn(ingest(std::move(*record)));
+     *  }
+     *  co_await scope.join();
+     * @endcode
+     */
+    class BoundedAsyncScope {
+    public:
+        template <typename Awaitable>
+        struct spawn_operation;
 
-                std::suspend_never initial_suspend() noexcept { return {}; }
-                std::suspend_never final_suspend() noexcept { return {}; }
-                void unhandled_exception() { std::terminate(); }
-                oneway_task get_return_object() { return {}; }
-                void return_void() {}
+        explicit BoundedAsyncScope(std::size_t maxInFlight) noexcept
+            : _maxInFlight{maxInFlight}
+        {
+            SUIL_ASSERT(maxInFlight != 0);
+        }
+
+        ~BoundedAsyncScope()
+        {
+            // scope must be co_awaited before it destructs.
+            SUIL_ASSERT(_continuation);
+            SUIL_ASSERT(_waiters.empty());
+        }
+
+        DISABLE_COPY(BoundedAsyncScope);
+        DISABLE_MOVE(BoundedAsyncScope);
+
+        /**
+         * Start \param awaitable, waiting for one of the running awaitables to
+         * complete if the limit is reached. Since tasks start running when they are
+         * created, a callable returning the awaitable can be given instead, it is
+         * only invoked once the awaitable can be started.
+         */
+        template<typename Awaitable>
+        [[nodiscard]] auto spawn(Awaitable&& awaitable)
+        {
+            return spawn_operation<std::decay_t<Awaitable>>{*this, std::forward<Awaitable>(awaitable)};
+        }
+
+        [[nodiscard]] auto join() noexcept
+        {
+            class awaiter
+            {
+                BoundedAsyncScope* _scope{nullptr};
+            public:
+                awaiter(BoundedAsyncScope* scope) noexcept : _scope(scope) {}
+
+                bool await_ready() noexcept
+                {
+                    return _scope->_count.load(std::memory_order_acquire) == 0;
+                }
+
+                bool await_suspend(std::coroutine_handle<> continuation) noexcept
+                {
+                    _scope->_continuation = continuation;
+                    return _scope->_count.fetch_sub(1u, std::memory_order_acq_rel) > 1u;
+                }
+
+                void await_resume() noexcept
+                {}
             };
-        };
 
-        std::atomic<size_t> _count{0};
+            return awaiter{ this };
+        }
+
+        std::size_t inFlight() const
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            return _inFlight;
+        }
+
+        std::size_t waiting() const
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            return _waiters.size;
+        }
+
+    private:
+        template<typename Awaitable>
+        void start(Awaitable&& awaitable)
+        {
+            [](BoundedAsyncScope* scope, Awaitable awaitable) -> detail::oneway_task
+            {
+                scope->on_work_started();
+                auto decrementOnCompletion = onScopeExit([scope] { scope->on_work_finished(); });
+                if constexpr (std::is_invocable_v<Awaitable&>) {
+                    co_await awaitable();
+                }
+                else {
+                    co_await std::move(awaitable);
+                }
+            }(this, std::move(awaitable));
+        }
+
+        bool tryAcquire() noexcept
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            if (_inFlight < _maxInFlight) {
+                _inFlight++;
+                return true;
+            }
+            return false;
+        }
+
+        void on_work_finished() noexcept
+        {
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                if (_waiters.empty()) {
+                    _inFlight--;
+                }
+                else {
+                    // the slot is handed over to the first waiting spawner
+                    _waiters.grant();
+                }
+            }
+
+            if (_count.fetch_sub(1u, std::memory_order_acq_rel) == 1) {
+                _continuation.resume();
+            }
+        }
+
+        void on_work_started() noexcept
+        {
+            SUIL_ASSERT(_count.load(std::memory_order_relaxed) != 0);
+            _count.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        std::atomic<size_t> _count{1};
         std::coroutine_handle<> _continuation{nullptr};
+        mutable std::mutex _lock{};
+        std::size_t _maxInFlight;
+        std::size_t _inFlight{0};
+        detail::wait_queue _waiters{};
     };
 
+    template <typename Awaitable>
+    struct BoundedAsyncScope::spawn_operation {
+        template <typename A>
+        spawn_operation(BoundedAsyncScope& scope, A&& awaitable)
+            : _scope{scope},
+              _awaitable{std::forward<A>(awaitable)}
+        {}
+
+        bool await_ready()
+        {
+            if (_scope.tryAcquire()) {
+                _scope.start(std::move(_awaitable));
+                return true;
+            }
+            return false;
+        }
+
+        bool await_suspend(std::coroutine_handle<> coroutine)
+        {
+            {
+                std::lock_guard<std::mutex> lk{_scope._lock};
+                if (_scope._inFlight == _scope._maxInFlight) {
+                    _scope._waiters.park(_waiter, coroutine, -1);
+                    return true;
+                }
+                _scope._inFlight++;
+            }
+
+            _scope.start(std::move(_awaitable));
+            return false;
+        }
+
+        void await_resume()
+        {
+            if (_waiter.granted) {
+                // resumed with a slot
+                _scope.start(std::move(_awaitable));
+            }
+        }
+
+    private:
+        BoundedAsyncScope& _scope;
+        Awaitable _awaitable;
+        detail::timed_waiter _waiter{};
+    };
 }
\ No newline at end of file
@@ -0,0 +1,88 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#pragma once
+
+#include <suil/async/detail/waiters.hpp>
+
+#include <atomic>
+#include <mutex>
+
+namespace suil {
+
+    /**
+     * A counting semaphore. Like \see AsyncMutex the state is a single atomic word,
+     * permits are taken and returned with a compare and swap as long as nobody is
+     * waiting. Once a coroutine has to wait, a flag in the state word routes all the
+     * operations through a FIFO of waiters which are granted their permits in order
+     * and resumed on the thread they were suspended on.
+     */
+    class AsyncSemaphore {
+    public:
+        struct acquire_operation;
+
+        explicit AsyncSemaphore(uint64 permits) noexcept;
+
+        ~AsyncSemaphore();
+
+        DISABLE_COPY(AsyncSemaphore);
+        DISABLE_MOVE(AsyncSemaphore);
+
+        /**
+         * Take \param n permits without waiting
+         * @return false if the permits are not available
+         */
+        bool tryAcquire(uint64 n = 1) noexcept;
+
+        /**
+         * Take \param n permits, waiting at most \param timeout for them
+         * @return co_await yields false if the wait timed out
+         */
+        acquire_operation acquire(uint64 n = 1, milliseconds timeout = DELAY_INF) noexcept;
+
+        /**
+         * Return \param n permits, waiting coroutines are granted their permits in
+         * the order they started waiting
+         */
+        void release(uint64 n = 1);
+
+        [[nodiscard]] uint64 available() const noexcept;
+        [[nodiscard]] std::size_t waiting() const;
+        [[nodiscard]] WaitStats getStats() const;
+
+    private:
+        friend struct acquire_operation;
+        static constexpr uint64 HAS_WAITERS = uint64(1) << 63;
+        void dispatch();
+        std::atomic<uint64> _state{0};
+        std::atomic<uint64> _acquired{0};
+        mutable std::mutex _lock{};
+        detail::wait_queue _waiters{};
+    };
+
+    struct AsyncSemaphore::acquire_operation {
+        acquire_operation(AsyncSemaphore& semaphore, uint64 n, int64 dd) noexcept
+            : _semaphore{semaphore},
+              _dd{dd}
+        {
+            _waiter.count = n;
+        }
+
+        bool await_ready() noexcept { return _semaphore.tryAcquire(_waiter.count); }
+        bool await_suspend(std::coroutine_handle<> coroutine);
+        bool await_resume();
+
+    private:
+        AsyncSemaphore& _semaphore;
+        int64 _dd{-1};
+        bool _suspended{false};
+        detail::timed_waiter _waiter{};
+    };
+}
@@ -0,0 +1,152 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#pragma once
+
+#include <suil/async/detail/waiters.hpp>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace suil {
+
+    class AsyncSharedMutex;
+
+    struct AsyncSharedMutexLock final {
+        explicit AsyncSharedMutexLock(AsyncSharedMutex& mutex, bool shared, std::adopt_lock_t) noexcept
+            : _mutex{&mutex},
+              _shared{shared}
+        {}
+
+        AsyncSharedMutexLock(AsyncSharedMutexLock&& other) noexcept
+            : _mutex{std::exchange(other._mutex, nullptr)},
+              _shared{other._shared}
+        {}
+
+        AsyncSharedMutexLock(const AsyncSharedMutexLock&) = delete;
+        AsyncSharedMutexLock& operator=(const AsyncSharedMutexLock&) = delete;
+
+        ~AsyncSharedMutexLock();
+
+    private:
+        AsyncSharedMutex* _mutex;
+        bool _shared;
+    };
+
+    /**
+     * A reader/writer mutex with a phase-fair policy: readers arriving while a writer
+     * holds or waits for the lock queue up behind it and are all admitted when it
+     * unlocks, ahead of the next writer. Neither readers nor writers can starve.
+     *
+     * Readers are counted on per-thread cache lines, an uncontended shared lock or
+     * unlock is a single atomic increment on the calling async thread's counter and
+     * readers on different threads never share a cache line. A reader may unlock on
+     * another thread than the one it locked on.
+     */
+    class AsyncSharedMutex {
+    public:
+        struct lock_operation;
+        struct lock_shared_operation;
+        struct scoped_lock_operation;
+        struct scoped_lock_shared_operation;
+
+        AsyncSharedMutex();
+        ~AsyncSharedMutex();
+
+        DISABLE_COPY(AsyncSharedMutex);
+        DISABLE_MOVE(AsyncSharedMutex);
+
+        bool tryLock();
+        lock_operation lockAsync() noexcept;
+        scoped_lock_operation scopedLockAsync() noexcept;
+        void unlock();
+
+        bool tryLockShared() noexcept;
+        lock_shared_operation lockSharedAsync() noexcept;
+        scoped_lock_shared_operation scopedLockSharedAsync() noexcept;
+        void unlockShared();
+
+    private:
+        friend struct lock_operation;
+        friend struct lock_shared_operation;
+
+        struct alignas(64) reader_slot {
+            // may go negative when readers unlock on another thread
+            std::atomic<int64> count{0};
+        };
+
+        static constexpr uint32 WRITER = 1;
+        reader_slot& slot() noexcept;
+        int64 readers() const noexcept;
+        bool lockSlow(detail::timed_waiter& w, std::coroutine_handle<> coro);
+        bool lockSharedSlow(detail::timed_waiter& w, std::coroutine_handle<> coro);
+        void readerLeft();
+
+        // WRITER is set while a writer holds the lock or waits for readers to leave,
+        // it only changes with the lock held
+        std::atomic<uint32> _state{0};
+        std::unique_ptr<reader_slot[]> _slots{};
+        uint16 _nSlots{0};
+        std::mutex _lock{};
+        // the head writer waits for the readers to leave
+        bool _draining{false};
+        detail::wait_queue _writers{};
+        detail::wait_queue _readers{};
+    };
+
+    struct AsyncSharedMutex::lock_operation {
+        explicit lock_operation(AsyncSharedMutex& mutex) noexcept
+            : _mutex{mutex}
+        {}
+
+        bool await_ready() noexcept { return _mutex.tryLock(); }
+        bool await_suspend(std::coroutine_handle<> coro) { return _mutex.lockSlow(_waiter, coro); }
+        void await_resume() const noexcept {}
+
+    protected:
+        AsyncSharedMutex& _mutex;
+    private:
+        detail::timed_waiter _waiter{};
+    };
+
+    struct AsyncSharedMutex::lock_shared_operation {
+        explicit lock_shared_operation(AsyncSharedMutex& mutex) noexcept
+            : _mutex{mutex}
+        {}
+
+        bool await_ready() noexcept { return _mutex.tryLockShared(); }
+        bool await_suspend(std::coroutine_handle<> coro) { return _mutex.lockSharedSlow(_waiter, coro); }
+        void await_resume() const noexcept {}
+
+    protected:
+        AsyncSharedMutex& _mutex;
+    private:
+        detail::timed_waiter _waiter{};
+    };
+
+    struct AsyncSharedMutex::scoped_lock_operation final : AsyncSharedMutex::lock_operation {
+        using AsyncSharedMutex::lock_operation::lock_operation;
+
+        [[nodiscard]]
+        AsyncSharedMutexLock await_resume() const noexcept {
+            return AsyncSharedMutexLock{_mutex, false, std::adopt_lock};
+        }
+    };
+
+    struct AsyncSharedMutex::scoped_lock_shared_operation final : AsyncSharedMutex::lock_shared_operation {
+        using AsyncSharedMutex::lock_shared_operation::lock_shared_operation;
+
+        [[nodiscard]]
+        AsyncSharedMutexLock await_resume() const noexcept {
+            return AsyncSharedMutexLock{_mutex, true, std::adopt_lock};
+        }
+    };
+}
@@ -10,6 +10,9 @@
 
 #pragma once
 
+#include <suil/async/cancel.hpp>
+#include <suil/async/fdwait.hpp>
+#include <suil/async/recvbuf.hpp>
 #include <suil/async/task.hpp>
 
 #include <suil/utils/utils.hpp>
@@ -35,40 +38,62 @@ namespace suil {
 
         int getLastError() const { return _error; }
 
-        auto send(const void* buf, std::size_t size, milliseconds timeout = DELAY_INF) -> Task<int>;
+        // cancelling \param token abandons a pending wait, the operation then fails with ECANCELED
+        auto send(const void* buf, std::size_t size, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
 
-        auto send(const std::span<const char>& buf, milliseconds timeout = DELAY_INF) {
-            return send(buf.data(), buf.size(), timeout);
+        auto send(const std::span<const char>& buf, milliseconds timeout = DELAY_INF, CancellationToken token = {}) {
+            return send(buf.data(), buf.size(), timeout, std::move(token));
         }
 
-        auto sendAll(const void* buf, std::size_t size, milliseconds timeout = DELAY_INF) -> Task<int>;
+        auto sendAll(const void* buf, std::size_t size, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
 
-        auto sendAll(const std::span<const char>& buf, milliseconds timeout = DELAY_INF) {
-            return sendAll(buf.data(), buf.size(), timeout);
+        auto sendAll(const std::span<const char>& buf, milliseconds timeout = DELAY_INF, CancellationToken token = {}) {
+            return sendAll(buf.data(), buf.size(), timeout, std::move(token));
         }
 
-        auto receive(void *buf, std::size_t size, milliseconds timeout = DELAY_INF) -> Task<int>;
+        auto receive(void *buf, std::size_t size, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
 
-        auto receive(std::span<char> buf, milliseconds timeout = DELAY_INF) {
-            return receive(buf.data(), buf.size(), timeout);
+        auto receive(std::span<char> buf, milliseconds timeout = DELAY_INF, CancellationToken token = {}) {
+            return receive(buf.data(), buf.size(), timeout, std::move(token));
         }
 
-        auto receiveAll(void* buf, std::size_t size, milliseconds timeout = DELAY_INF) -> Task<int>;
+        auto receiveAll(void* buf, std::size_t size, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
 
-        auto receiveAll(std::span<char> buf, milliseconds timeout = DELAY_INF) {
-            return receiveAll(buf.data(), buf.size(), timeout);
+        auto receiveAll(std::span<char> buf, milliseconds timeout = DELAY_INF, CancellationToken token = {}) {
+            return receiveAll(buf.data(), buf.size(), timeout, std::move(token));
         }
 
+        /**
+         * Receive into a buffer borrowed from the receiving thread's \see RecvBufferPool.
+         * No buffer is held while waiting for the socket to become readable.
+         *
+         * @param timeout the maximum time to wait for data
+         * @param token cancels the wait for data, the error is then ECANCELED
+         * @return a buffer holding the received data, an empty buffer is returned
+         * on error or when the peer closed the connection (see getLastError())
+         */
+        auto receiveBuffered(milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<RecvBuffer>;
+
         void bindToThread(uint16 tID);
 
+        /**
+         * Let the socket's timeouts expire up to \param slack late. Idle connections
+         * with nearby deadlines then time out on a single wakeup of their thread.
+         */
+        void setTimeoutSlack(milliseconds slack) { _slack = slack; }
+
     protected:
-        Socket(int fd, int err) : _fd{fd}, _error{0}
+        Socket(int fd, int err) : _fd{fd}, _error{int16(err)}
         {}
 
         Socket() = default;
 
+        // the error to report for a wait on the socket which did not fire
+        static int16 waitError(Event::State ev);
+
         int _fd{INVALID_FD};
         int16  _error{0};
         uint16  _tID{THREAD_ID_ANY};
+        milliseconds _slack{0};
     };
 }
\ No newline at end of file
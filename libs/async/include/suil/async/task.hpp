@@ -15,11 +15,12 @@
 #include <suil/async/scheduler.hpp>
 
 namespace suil {
-    template <typename T = void, bool Joinable = false>
+    template <typename T = void, bool Joinable = false, bool Local = false>
     class task
     {
+        static_assert(!(Joinable && Local), "Joinable tasks are joined from another thread");
     public:
-        using promise_type = detail::promise_t<task, T, Joinable>;
+        using promise_type = detail::promise_t<task, T, Joinable, Local>;
 
         task() noexcept = default;
         task(std::coroutine_handle<promise_type> coroutine) noexcept
@@ -95,17 +96,51 @@ namespace suil {
         }
 
         // The return value of await_resume is the final result of `co_await
-        // this_task` once the coroutine associated with this task completes
-        auto await_resume() const noexcept {
+        // this_task` once the coroutine associated with this task completes.
+        // Awaiting a named task yields a reference to the result stored in the
+        // task's frame, which is only moved if the awaiter constructs a value
+        // from it, and must not be bound to a reference outliving the task
+        decltype(auto) await_resume() const noexcept {
             if constexpr (std::is_same_v<T, void>) {
                 return;
             }
             else {
+                SUIL_ASSERT(promise().hasData);
                 return std::move(promise().data);
             }
         }
 
+        // Awaiting a named task yields a reference to its result (\see await_resume)
+        auto operator co_await() & noexcept {
+            return awaiter_t<false>{*this};
+        }
+
+        // Awaiting a temporary task yields its result by value, the frame holding
+        // the result is destroyed with the temporary at the end of the full expression
+        auto operator co_await() && noexcept {
+            return awaiter_t<true>{*this};
+        }
+
     protected:
+        template <bool ByValue>
+        struct awaiter_t {
+            using result_t = std::conditional_t<ByValue, T, decltype(std::declval<const task&>().await_resume())>;
+
+            bool await_ready() const noexcept {
+                return self.await_ready();
+            }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> coroutine) noexcept {
+                return self.await_suspend(coroutine);
+            }
+
+            result_t await_resume() const noexcept(!ByValue || std::is_void_v<T> || std::is_nothrow_move_constructible_v<T>) {
+                return self.await_resume();
+            }
+
+            task& self;
+        };
+
         [[nodiscard]] promise_type& promise() const noexcept {
             return _coroutine.promise();
         }
@@ -113,6 +148,69 @@ namespace suil {
         std::coroutine_handle<promise_type> _coroutine = nullptr;
     };
 
+    /**
+     * A task which only starts running when awaited. Control is transferred into
+     * the task when it is awaited and back to the awaiting coroutine when it
+     * completes, the continuation is therefore installed before the task runs and
+     * no atomic handshake is needed. As the task's frame never outlives the
+     * co_await expression, the compiler is free to elide its allocation into the
+     * awaiting coroutine's frame.
+     *
+     * Prefer over \see Task for internal steps which are awaited right away, use
+     * Task for work that must start before it is awaited. Unlike Task, exceptions
+     * escaping a LazyTask are rethrown in the awaiting coroutine.
+     */
+    template <typename T = void>
+    class [[nodiscard]] LazyTask
+    {
+    public:
+        using promise_type = detail::lazy_promise_t<LazyTask, T>;
+
+        LazyTask() noexcept = default;
+
+        explicit LazyTask(std::coroutine_handle<promise_type> coroutine) noexcept
+            : _coroutine{coroutine}
+        {}
+
+        DISABLE_COPY(LazyTask);
+
+        LazyTask(LazyTask&& other) noexcept
+            : _coroutine{std::exchange(other._coroutine, nullptr)}
+        {}
+
+        LazyTask& operator=(LazyTask&& other) noexcept {
+            if (this != &other) {
+                if (_coroutine) {
+                    _coroutine.destroy();
+                }
+                _coroutine = std::exchange(other._coroutine, nullptr);
+            }
+            return *this;
+        }
+
+        ~LazyTask() noexcept {
+            if (_coroutine) {
+                _coroutine.destroy();
+            }
+        }
+
+        [[nodiscard]] bool await_ready() const noexcept {
+            return !_coroutine || _coroutine.done();
+        }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> coroutine) noexcept {
+            _coroutine.promise().continuation = coroutine;
+            return _coroutine;
+        }
+
+        T await_resume() {
+            return _coroutine.promise().result();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> _coroutine = nullptr;
+    };
+
     /**
      * Suspend the current coroutine to be scheduled for execution on a different
      * thread by the supplied scheduler. Remember to `co_await` this function's
@@ -159,4 +257,13 @@ namespace suil {
 
     template <typename T = void>
     using Task = task<T, false>;
+
+    /**
+     * A \see Task which, along with the coroutine awaiting it, never leaves the
+     * thread it was started on. The continuation is stored without the atomic
+     * handshake Task uses to guard against the task completing on another thread.
+     * Debug builds assert that neither the task nor its awaiter migrated.
+     */
+    template <typename T = void>
+    using LocalTask = task<T, false, true>;
 }
\ No newline at end of file
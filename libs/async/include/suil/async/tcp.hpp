@@ -14,6 +14,7 @@
 #include <suil/async/socket.hpp>
 
 #include <span>
+#include <vector>
 
 namespace suil {
 
@@ -37,6 +38,23 @@ namespace suil {
         static Task<TcpSocket> connect(const SocketAddress& addr, milliseconds timeout = DELAY_INF);
         static Task<TcpSocket> connect(const SocketAddress& addr, uint16 queueID, milliseconds timeout = DELAY_INF);
 
+        /**
+         * Connect to the first reachable address (Happy Eyeballs, RFC 8305). Address
+         * families are interleaved and a new attempt is started every \param stagger
+         * or as soon as the previous attempt fails, without cancelling attempts that
+         * are still in progress. The first connection to succeed is returned and
+         * all the other attempts are closed.
+         *
+         * @param addrs the candidate addresses, in order of preference (\see SocketAddress::remoteAll)
+         * @param stagger the delay between the start of two connection attempts
+         * @param timeout the maximum time to wait for any attempt to succeed
+         */
+        static Task<TcpSocket> connectAny(
+                std::vector<SocketAddress> addrs,
+                milliseconds stagger = milliseconds{250},
+                milliseconds timeout = DELAY_INF,
+                uint16 queueID = THREAD_ID_ANY);
+
         operator bool() const { return isValid(); }
 
         [[nodiscard]]
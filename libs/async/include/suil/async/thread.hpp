@@ -14,6 +14,11 @@
 #include <suil/async/fdwait.hpp>
 #include <suil/async/detail/concurrentqueue.h>
 
+#include <map>
+#include <vector>
+
+struct epoll_event;
+
 namespace suil {
 
     class Thread {
@@ -38,8 +43,12 @@ namespace suil {
         void schedule(std::coroutine_handle<> coro);
         bool add(Event *event);
         void add(Delay *timer);
+        void add(Alarm *alarm);
         void remove(Event *event);
         void remove(Delay *timer);
+        void cancel(Event *event);
+        void cancel(Delay *timer);
+        bool cancel(Alarm *alarm);
         void abort();
         ~Thread();
 
@@ -48,11 +57,20 @@ namespace suil {
         void handleEvent(Event *event);
         void cancelTimer(Timer& handle);
         void addTimer(Timer& entry);
+        void unlinkTimer(Timer& timer);
         void fireExpiredTimers();
-        int computeWaitTimeout();
+        // nanoseconds until the next timer expires, -1 if there is none
+        int64 computeWaitTimeout();
+        int wait(struct epoll_event *events, int maxEvents);
         void handleThreadEvent();
+        void handleTimerEvent();
         void record();
-        mill_list _timers{};
+        using TimerBuckets = std::map<int64, mill_list>;
+        void releaseBucket(TimerBuckets::iterator bucket);
+        // timers grouped by expiry, the timers of a bucket fire on the same wakeup
+        TimerBuckets _timers{};
+        // emptied buckets kept for reuse, re-arming a timer then needs no allocation
+        std::vector<TimerBuckets::node_type> _spareBuckets{};
         std::mutex _timersLock;
         uint16_t _id{0};
         Stats _stats{};
@@ -61,6 +79,9 @@ namespace suil {
         std::thread _thread;
         int _epfd{INVALID_FD};
         int _evfd{INVALID_FD};
+        // sub-millisecond waits without epoll_pwait2
+        int _tmfd{INVALID_FD};
+        bool _pwait2{true};
         moodycamel::ConcurrentQueue<std::coroutine_handle<>> _scheduleQ;
     };
 }
\ No newline at end of file
@@ -0,0 +1,132 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-21
+ */
+
+#pragma once
+
+#include <suil/async/addr.hpp>
+#include <suil/async/socket.hpp>
+
+#include <span>
+
+#ifndef SUIL_ASYNC_UDP_MAX_BATCH
+#define SUIL_ASYNC_UDP_MAX_BATCH 64u
+#endif
+
+namespace suil {
+
+    /**
+     * A datagram used with the batched \see UdpSocket API
+     */
+    struct Datagram {
+        // the payload to send, or the storage to receive into
+        std::span<char> buf{};
+        // the destination of a send, or the source of a received datagram
+        SocketAddress addr{};
+        // the number of bytes sent or received
+        std::size_t size{0};
+        // when GRO is enabled, the size of the segments coalesced into buf
+        uint16 segmentSize{0};
+        // true if the received datagram did not fit in buf and was cut to size
+        bool truncated{false};
+    };
+
+    /**
+     * @brief An abstraction over a UDP socket
+     */
+    class UdpSocket : public Socket {
+    public:
+        UdpSocket() noexcept = default;
+
+        explicit UdpSocket(int fd, int err = 0, uint16 tId = THREAD_ID_ANY);
+
+        ~UdpSocket() noexcept override = default;
+
+        UdpSocket(UdpSocket&& other) noexcept;
+        UdpSocket& operator=(UdpSocket&& other) noexcept;
+
+        UdpSocket(const UdpSocket&) = delete;
+        UdpSocket& operator=(const UdpSocket&) = delete;
+
+        /**
+         * Create a UDP socket bound to the given local address
+         * @param addr the local address, use SocketAddress::any(0) for an ephemeral port
+         * @param tId the async thread to bind the socket to
+         * @param reuseAddr set SO_REUSEADDR, needed by multicast receivers sharing
+         *  a group's port
+         */
+        static UdpSocket bind(const SocketAddress& addr, uint16 tId = THREAD_ID_ANY, bool reuseAddr = false);
+
+        operator bool() const { return isValid(); }
+
+        /**
+         * Set the default destination of the socket, after which Socket::send
+         * and Socket::receive can be used
+         */
+        int connect(const SocketAddress& peer);
+
+        // cancelling \param token abandons a pending wait, the operation then fails with ECANCELED
+        auto sendTo(const SocketAddress& to, const void *buf, std::size_t size,
+                    milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        auto sendTo(const SocketAddress& to, const std::span<const char>& buf,
+                    milliseconds timeout = DELAY_INF, CancellationToken token = {}) {
+            return sendTo(to, buf.data(), buf.size(), timeout, std::move(token));
+        }
+
+        /**
+         * Receive a single datagram, a datagram larger than \param size is cut to
+         * size and the error is set to EMSGSIZE (see getLastError())
+         * @return the number of bytes stored in \param buf, -1 on error
+         */
+        auto receiveFrom(void *buf, std::size_t size, SocketAddress& from,
+                         milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        auto receiveFrom(std::span<char> buf, SocketAddress& from,
+                         milliseconds timeout = DELAY_INF, CancellationToken token = {}) {
+            return receiveFrom(buf.data(), buf.size(), from, timeout, std::move(token));
+        }
+
+        /**
+         * Send the given datagrams, up to SUIL_ASYNC_UDP_MAX_BATCH per sendmmsg call
+         * @return the number of datagrams sent, -1 if none could be sent
+         */
+        auto sendMany(std::span<Datagram> dgrams, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        /**
+         * Wait for at least one datagram and receive as many of the pending
+         * datagrams as fit in \param dgrams with a single recvmmsg call. Datagrams
+         * which did not fit in their buffer are flagged \see Datagram::truncated
+         * @return the number of datagrams received, -1 on error
+         */
+        auto receiveMany(std::span<Datagram> dgrams, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        /**
+         * Enable UDP generic segmentation offload, each sent buffer is split
+         * into \param size datagrams by the kernel (0 disables)
+         */
+        bool setSegmentSize(uint16 size);
+
+        /**
+         * Enable UDP generic receive offload, datagrams of the same flow are
+         * coalesced into a single receive (\see Datagram::segmentSize)
+         */
+        bool enableGro(bool on = true);
+
+        bool joinGroup(const SocketAddress& group, unsigned ifIndex = 0);
+        bool leaveGroup(const SocketAddress& group, unsigned ifIndex = 0);
+        bool setMulticastLoop(bool on);
+        bool setMulticastTtl(int ttl);
+
+    private:
+        bool membership(const SocketAddress& group, unsigned ifIndex, bool join);
+        bool isIpv6() const;
+        bool _gro{false};
+    };
+}
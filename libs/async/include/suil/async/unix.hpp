@@ -0,0 +1,141 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-21
+ */
+
+#pragma once
+
+#include <suil/async/addr.hpp>
+#include <suil/async/socket.hpp>
+
+#include <span>
+#include <utility>
+
+#ifndef SUIL_ASYNC_UNIX_MAX_FDS
+#define SUIL_ASYNC_UNIX_MAX_FDS 32u
+#endif
+
+namespace suil {
+
+    /**
+     * @brief An abstraction over a unix domain stream or seqpacket socket
+     */
+    class UnixSocket : public Socket {
+    public:
+        typedef enum {
+            STREAM,
+            SEQPACKET
+        } Type;
+
+        UnixSocket() noexcept = default;
+
+        explicit UnixSocket(int fd, int err = 0, uint16 tId = THREAD_ID_ANY);
+
+        ~UnixSocket() noexcept override = default;
+
+        UnixSocket(UnixSocket&& other) noexcept;
+        UnixSocket& operator=(UnixSocket&& other) noexcept;
+
+        UnixSocket(const UnixSocket&) = delete;
+        UnixSocket& operator=(const UnixSocket&) = delete;
+
+        static Task<UnixSocket> connect(const SocketAddress& addr, Type type = STREAM, milliseconds timeout = DELAY_INF);
+        static Task<UnixSocket> connect(const SocketAddress& addr, Type type, uint16 queueID, milliseconds timeout = DELAY_INF);
+
+        /**
+         * Create a pair of connected unix sockets (\see socketpair)
+         */
+        static std::pair<UnixSocket, UnixSocket> pair(Type type = STREAM, uint16 tId = THREAD_ID_ANY);
+
+        operator bool() const { return isValid(); }
+
+        [[nodiscard]]
+        const SocketAddress& address() const { return _address; }
+
+        /**
+         * Send the given file descriptors (SCM_RIGHTS) along with \param buf. The
+         * descriptors remain open in the sending process.
+         *
+         * Cancelling \param token abandons a pending wait, the operation then fails
+         * with ECANCELED.
+         *
+         * @return the number of bytes of \param buf sent, -1 on error
+         */
+        auto sendFds(std::span<const int> fds, const void *buf, std::size_t size,
+                     milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        /**
+         * Send the given file descriptors with a single byte of payload,
+         * stream sockets cannot carry ancillary data without payload
+         */
+        auto sendFds(std::span<const int> fds, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        /**
+         * Receive data along with any file descriptors passed by the peer. The
+         * descriptors are written to \param fds in order, entries that were not
+         * filled are set to INVALID_FD. Descriptors that do not fit in \param fds
+         * are closed by the kernel.
+         *
+         * @return the number of bytes received into \param buf, -1 on error
+         */
+        auto recvFds(std::span<int> fds, void *buf, std::size_t size,
+                     milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        auto recvFds(std::span<int> fds, milliseconds timeout = DELAY_INF, CancellationToken token = {}) -> Task<int>;
+
+        void close() noexcept override;
+        int detach() override;
+
+    private:
+        friend class UnixListener;
+        SocketAddress _address{};
+    };
+
+    class UnixListener {
+    public:
+        ~UnixListener() noexcept;
+
+        UnixListener(UnixListener&& other) noexcept;
+        UnixListener& operator=(UnixListener&& other) noexcept;
+
+        UnixListener(const UnixListener&) = delete;
+        UnixListener& operator=(const UnixListener&) = delete;
+
+        operator bool() const { return _fd > 0; }
+
+        auto acceptOn(uint16 tId, milliseconds timeout = DELAY_INF) -> Task<UnixSocket>;
+
+        auto accept(milliseconds timeout = DELAY_INF) -> Task<UnixSocket> {
+            return acceptOn(THREAD_ID_ANY, timeout);
+        }
+
+        /**
+         * Close the listener, a filesystem socket path created by the
+         * listener is removed
+         */
+        void close();
+
+        [[nodiscard]]
+        int getLastError() const { return _error; }
+
+        [[nodiscard]]
+        const SocketAddress& address() const { return _address; }
+
+        static UnixListener listen(const SocketAddress& addr, int backlog, UnixSocket::Type type = UnixSocket::STREAM);
+
+    private:
+        UnixListener() = default;
+        UnixListener(int fd, const SocketAddress& addr, int err = 0)
+            : _fd{fd}, _address{addr}, _error{err}
+        {}
+
+        int _fd{INVALID_FD};
+        SocketAddress _address{};
+        int _error{0};
+    };
+}
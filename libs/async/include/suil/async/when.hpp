@@ -0,0 +1,247 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-24
+ */
+
+#pragma once
+
+#include <suil/async/cancel.hpp>
+#include <suil/async/scope.hpp>
+#include <suil/async/task.hpp>
+
+#include <optional>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+namespace suil {
+
+    namespace detail {
+
+        template <typename T>
+        using when_all_value_t = std::conditional_t<std::is_void_v<T>, std::monostate, T>;
+
+        /**
+         * Waits for a task to complete without taking its result
+         */
+        template <typename T>
+        struct when_ready {
+            Task<T>& task;
+
+            bool await_ready() const noexcept { return task.await_ready(); }
+            auto await_suspend(std::coroutine_handle<> coroutine) noexcept { return task.await_suspend(coroutine); }
+            void await_resume() const noexcept {}
+        };
+
+        template <typename T>
+        when_all_value_t<T> when_all_take(Task<T>& task)
+        {
+            if constexpr (std::is_void_v<T>) {
+                return {};
+            }
+            else {
+                return std::move((*task).get());
+            }
+        }
+
+        template <typename T>
+        struct when_any_state {
+            explicit when_any_state(std::size_t count, std::optional<CancellationSource> source = std::nullopt) noexcept
+                : refs{count + 1},
+                  source{std::move(source)}
+            {}
+
+            void complete(std::size_t i, when_all_value_t<T>&& v)
+            {
+                if (decided.exchange(true, std::memory_order_acq_rel)) {
+                    // not the first to complete
+                    return;
+                }
+
+                index = i;
+                value.emplace(std::move(v));
+                if (source) {
+                    // the losers are resumed on their own threads with a cancelled status
+                    source->cancel();
+                }
+                if (ready.exchange(true, std::memory_order_acq_rel)) {
+                    // the waiter is already suspended
+                    waiter.resume();
+                }
+            }
+
+            void release() noexcept
+            {
+                if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                    delete this;
+                }
+            }
+
+            // one reference per child plus one for the waiter
+            std::atomic<std::size_t> refs;
+            std::atomic_bool decided{false};
+            std::atomic_bool ready{false};
+            std::size_t index{0};
+            std::optional<when_all_value_t<T>> value{};
+            std::coroutine_handle<> waiter{};
+            std::optional<CancellationSource> source{};
+        };
+
+        // Tasks only resume coroutines when they complete, each child is therefore
+        // awaited by a detached coroutine whose frame comes from the frame pool
+        template <typename T>
+        oneway_task when_any_child(when_any_state<T> *state, Task<T> task, std::size_t index)
+        {
+            co_await when_ready<T>{task};
+            state->complete(index, when_all_take(task));
+            state->release();
+        }
+
+        template <typename T>
+        struct when_any_operation {
+            explicit when_any_operation(when_any_state<T> *state) noexcept
+                : _state{state}
+            {}
+
+            when_any_operation(when_any_operation&& other) noexcept
+                : _state{std::exchange(other._state, nullptr)}
+            {}
+
+            when_any_operation& operator=(when_any_operation&&) = delete;
+            DISABLE_COPY(when_any_operation);
+
+            ~when_any_operation() noexcept
+            {
+                if (_state != nullptr) {
+                    _state->release();
+                }
+            }
+
+            bool await_ready() const noexcept
+            {
+                return _state->ready.load(std::memory_order_acquire);
+            }
+
+            bool await_suspend(std::coroutine_handle<> coroutine) noexcept
+            {
+                _state->waiter = coroutine;
+                return !_state->ready.exchange(true, std::memory_order_acq_rel);
+            }
+
+            auto await_resume()
+            {
+                if constexpr (std::is_void_v<T>) {
+                    return _state->index;
+                }
+                else {
+                    return std::pair<std::size_t, T>{_state->index, std::move(*_state->value)};
+                }
+            }
+
+        private:
+            when_any_state<T> *_state{nullptr};
+        };
+    }
+
+    /**
+     * Wait for all the given tasks to complete. Tasks start running when they
+     * are created, so they already run concurrently and are simply awaited in
+     * turn, which requires neither a countdown nor additional coroutine frames.
+     *
+     * @return co_await yields a tuple with the results of the tasks, std::monostate
+     * for Task<void>
+     */
+    template <typename... Ts>
+    auto whenAll(Task<Ts>... tasks) -> Task<std::tuple<detail::when_all_value_t<Ts>...>>
+    {
+        (co_await detail::when_ready<Ts>{tasks}, ...);
+        co_return std::tuple<detail::when_all_value_t<Ts>...>{detail::when_all_take(tasks)...};
+    }
+
+    /**
+     * Wait for all the given tasks to complete, \see whenAll
+     * @return co_await yields the results of the tasks in the same order
+     */
+    template <typename T> requires (!std::is_void_v<T>)
+    auto whenAll(std::vector<Task<T>> tasks) -> Task<std::vector<T>>
+    {
+        std::vector<T> results;
+        results.reserve(tasks.size());
+        for (auto& task: tasks) {
+            co_await detail::when_ready<T>{task};
+            results.push_back(detail::when_all_take(task));
+        }
+        co_return results;
+    }
+
+    inline auto whenAll(std::vector<Task<>> tasks) -> Task<>
+    {
+        for (auto& task: tasks) {
+            co_await task;
+        }
+    }
+
+    /**
+     * Wait for the first of the given tasks to complete. The remaining tasks keep
+     * running to completion in the background and their results are dropped.
+     *
+     * @return co_await yields the index of the first task to complete along with
+     * its result, only the index for Task<void>
+     */
+    template <typename T>
+    auto whenAny(std::vector<Task<T>> tasks) -> detail::when_any_operation<T>
+    {
+        SUIL_ASSERT(!tasks.empty());
+        auto state = new detail::when_any_state<T>(tasks.size());
+        for (auto i = 0u; i < tasks.size(); i++) {
+            detail::when_any_child(state, std::move(tasks[i]), i);
+        }
+        return detail::when_any_operation<T>{state};
+    }
+
+    template <typename T, typename... Ts> requires (std::is_same_v<Task<T>, Ts> && ...)
+    auto whenAny(Task<T> first, Ts... rest) -> detail::when_any_operation<T>
+    {
+        auto state = new detail::when_any_state<T>(1 + sizeof...(Ts));
+        std::size_t index{0};
+        detail::when_any_child(state, std::move(first), index++);
+        (detail::when_any_child(state, std::move(rest), index++), ...);
+        return detail::when_any_operation<T>{state};
+    }
+
+    /**
+     * Wait for the first of the given tasks to complete and cancel the others with
+     * \param source, whose token the tasks are expected to observe. Cancellation is
+     * cooperative, the losers still complete in the background once they notice it.
+     *
+     * @code
+     * CancellationSource source;
+     * auto [index, value] = co_await whenAny(source, fetch(a, source.token()), fetch(b, source.token()));
+     * @endcode
+     */
+    template <typename T>
+    auto whenAny(CancellationSource source, std::vector<Task<T>> tasks) -> detail::when_any_operation<T>
+    {
+        SUIL_ASSERT(!tasks.empty());
+        auto state = new detail::when_any_state<T>(tasks.size(), std::move(source));
+        for (auto i = 0u; i < tasks.size(); i++) {
+            detail::when_any_child(state, std::move(tasks[i]), i);
+        }
+        return detail::when_any_operation<T>{state};
+    }
+
+    template <typename T, typename... Ts> requires (std::is_same_v<Task<T>, Ts> && ...)
+    auto whenAny(CancellationSource source, Task<T> first, Ts... rest) -> detail::when_any_operation<T>
+    {
+        auto state = new detail::when_any_state<T>(1 + sizeof...(Ts), std::move(source));
+        std::size_t index{0};
+        detail::when_any_child(state, std::move(first), index++);
+        (detail::when_any_child(state, std::move(rest), index++), ...);
+        return detail::when_any_operation<T>{state};
+    }
+}
@@ -9,14 +9,23 @@
  */
 
 #include "suil/async/addr.hpp"
+#include "suil/async/detail/resolver.hpp"
+#include "suil/async/detail/waiters.hpp"
 #include "suil/async/fdwait.hpp"
 
+#include <poll.h>
+
 #include "dns/dns.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
+#include <cstddef>
 #include <cstring>
+#include <memory>
+#include <mutex>
 #include <system_error>
+#include <unordered_map>
 
 #include <arpa/inet.h>
 #include <ifaddrs.h>
@@ -24,9 +33,271 @@
 #include <sys/un.h>
 
 namespace suil {
-    static struct dns_resolv_conf *suil_dns_conf{nullptr};
-    static struct dns_hosts *suil_dns_hosts{nullptr};
-    static struct dns_hints *suil_dns_hints{nullptr};
+    static_assert(SocketAddress::MAX_ADDRESS_SIZE >= sizeof(struct sockaddr_un));
+    static_assert(SocketAddress::MAX_IP_ADDRESS_SIZE >= sizeof(struct sockaddr_in6));
+
+    namespace {
+
+        struct DnsAnswer {
+            std::vector<SocketAddress> addrs{};
+            // non-zero if the name could not be resolved
+            int error{0};
+            // 0 if the answer must not be cached
+            int64 expires{0};
+        };
+
+        struct DnsLookup {
+            std::mutex lock{};
+            // followers parked until the leader's answer is published
+            detail::wait_queue waiters{};
+            bool done{false};
+            DnsAnswer answer{};
+
+            void publish(const DnsAnswer& result)
+            {
+                std::lock_guard<std::mutex> lk{lock};
+                answer = result;
+                done = true;
+                while (!waiters.empty()) {
+                    waiters.grant();
+                }
+            }
+        };
+
+        /**
+         * Waits for the answer of an in-flight lookup until the follower's own deadline
+         */
+        struct dns_follower {
+            dns_follower(DnsLookup& lookup, int64 dd) noexcept
+                : _lookup{lookup},
+                  _dd{dd}
+            {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> coroutine)
+            {
+                std::lock_guard<std::mutex> lk{_lookup.lock};
+                if (_lookup.done) {
+                    return false;
+                }
+                _suspended = true;
+                _lookup.waiters.park(_waiter, coroutine, _dd);
+                return true;
+            }
+
+            DnsAnswer await_resume()
+            {
+                std::lock_guard<std::mutex> lk{_lookup.lock};
+                if (_suspended && !_lookup.waiters.resumed(_waiter)) {
+                    // timed out while the leader is still querying
+                    return DnsAnswer{.error = ETIMEDOUT};
+                }
+                return _lookup.answer;
+            }
+
+        private:
+            DnsLookup& _lookup;
+            int64 _dd{-1};
+            detail::timed_waiter _waiter{};
+            bool _suspended{false};
+        };
+
+        struct DnsEntry {
+            DnsAnswer answer{};
+            std::shared_ptr<DnsLookup> inflight{};
+        };
+
+        struct DnsCache {
+            std::mutex lock{};
+            std::unordered_map<std::string, DnsEntry> entries{};
+        };
+
+        DnsCache& dnsCache()
+        {
+            static DnsCache cache{};
+            return cache;
+        }
+    }
+
+    static void dnsParse(struct dns_packet *P, enum dns_type type, DnsAnswer& answer)
+    {
+        unsigned ttl{SUIL_ASYNC_DNS_MAX_TTL};
+        struct dns_rr rr{};
+        int error{0};
+
+        struct dns_rr_i rri{};
+        rri.section = DNS_S_AN;
+        rri.type = type;
+        dns_rr_i_init(&rri, P);
+        while (dns_rr_grep(&rr, 1, &rri, P, &error)) {
+            SocketAddress addr{};
+            if (type == DNS_T_A) {
+                struct dns_a a{};
+                if (dns_a_parse(&a, &rr, P) != 0) {
+                    continue;
+                }
+                auto inaddr = (struct sockaddr_in *) addr.raw();
+                inaddr->sin_family = AF_INET;
+                inaddr->sin_addr = a.addr;
+            }
+            else {
+                struct dns_aaaa aaaa{};
+                if (dns_aaaa_parse(&aaaa, &rr, P) != 0) {
+                    continue;
+                }
+                auto inaddr = (struct sockaddr_in6 *) addr.raw();
+                inaddr->sin6_family = AF_INET6;
+                inaddr->sin6_addr = aaaa.addr;
+            }
+            ttl = std::min(ttl, rr.ttl);
+            answer.addrs.push_back(addr);
+        }
+
+        if (answer.addrs.empty()) {
+            // negative answers are cached for the SOA minimum TTL (RFC 2308)
+            ttl = SUIL_ASYNC_DNS_NEGATIVE_TTL;
+            rri = {};
+            rri.section = DNS_S_NS;
+            rri.type = DNS_T_SOA;
+            dns_rr_i_init(&rri, P);
+            if (dns_rr_grep(&rr, 1, &rri, P, &error)) {
+                struct dns_soa soa{};
+                if (dns_soa_parse(&soa, &rr, P) == 0) {
+                    ttl = std::min({ttl, rr.ttl, soa.minimum});
+                }
+            }
+            answer.error = EADDRNOTAVAIL;
+        }
+
+        answer.expires = fastnow() + int64(std::max(ttl, SUIL_ASYNC_DNS_MIN_TTL)) * 1000;
+    }
+
+    static LazyTask<DnsAnswer> dnsQuery(std::string name, enum dns_type type, int64 deadline)
+    {
+        DnsAnswer answer{};
+        auto reply = co_await detail::stub_resolver::query(std::move(name), type, deadline);
+        if (reply.packet == nullptr) {
+            answer.error = reply.error;
+            co_return answer;
+        }
+
+        dnsParse(reply.packet, type, answer);
+        free(reply.packet);
+        co_return answer;
+    }
+
+    static LazyTask<DnsAnswer> dnsFlight(std::string name, enum dns_type type, std::string key,
+                                         std::shared_ptr<DnsLookup> lookup, int64 deadline)
+    {
+        auto answer = co_await dnsQuery(name, type, deadline);
+        {
+            auto& cache = dnsCache();
+            std::lock_guard<std::mutex> lk{cache.lock};
+            auto it = cache.entries.find(key);
+            if (it != cache.entries.end()) {
+                if (answer.expires != 0) {
+                    it->second.answer = answer;
+                }
+                else if (it->second.answer.expires == 0) {
+                    // transient failures are not cached
+                    cache.entries.erase(it);
+                    it = cache.entries.end();
+                }
+
+                if (it != cache.entries.end()) {
+                    it->second.inflight.reset();
+                }
+            }
+        }
+
+        lookup->publish(answer);
+        co_return answer;
+    }
+
+    static VoidTask<> dnsRefresh(std::string name, enum dns_type type, std::string key, std::shared_ptr<DnsLookup> lookup)
+    {
+        co_await dnsFlight(std::move(name), type, std::move(key), std::move(lookup),
+                           afterd(milliseconds{SUIL_ASYNC_DNS_REFRESH_TIMEOUT}));
+    }
+
+    static void dnsTrim(DnsCache& cache, int64 now)
+    {
+        // drop entries that can no longer be served, then anything idle if still full
+        for (auto it = cache.entries.begin(); it != cache.entries.end();) {
+            auto& entry = it->second;
+            bool dead = entry.answer.expires + SUIL_ASYNC_DNS_STALE_TTL * 1000 <= now;
+            it = (dead && !entry.inflight)? cache.entries.erase(it) : std::next(it);
+        }
+
+        for (auto it = cache.entries.begin();
+             cache.entries.size() >= SUIL_ASYNC_DNS_CACHE_SIZE && it != cache.entries.end();) {
+            it = it->second.inflight? std::next(it) : cache.entries.erase(it);
+        }
+    }
+
+    static Task<DnsAnswer> dnsLookup(std::string name, enum dns_type type, int64 deadline)
+    {
+        std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+        auto key = (type == DNS_T_A? "A:" : "AAAA:") + name;
+
+        auto& cache = dnsCache();
+        std::shared_ptr<DnsLookup> lookup{};
+        DnsAnswer answer{};
+        bool leader{false}, refresh{false};
+        {
+            std::lock_guard<std::mutex> lk{cache.lock};
+            auto now = fastnow();
+            auto it = cache.entries.find(key);
+            if (it == cache.entries.end()) {
+                if (cache.entries.size() >= SUIL_ASYNC_DNS_CACHE_SIZE) {
+                    dnsTrim(cache, now);
+                }
+                it = cache.entries.emplace(key, DnsEntry{}).first;
+            }
+
+            auto& entry = it->second;
+            if (entry.answer.expires > now) {
+                answer = entry.answer;
+            }
+            else if (entry.answer.expires != 0 &&
+                     entry.answer.error == 0 &&
+                     entry.answer.expires + SUIL_ASYNC_DNS_STALE_TTL * 1000 > now)
+            {
+                // stale-while-revalidate
+                answer = entry.answer;
+                if (!entry.inflight) {
+                    lookup = entry.inflight = std::make_shared<DnsLookup>();
+                    refresh = true;
+                }
+            }
+            else if (entry.inflight) {
+                // single flight, wait for the lookup already in progress
+                lookup = entry.inflight;
+            }
+            else {
+                lookup = entry.inflight = std::make_shared<DnsLookup>();
+                leader = true;
+            }
+        }
+
+        if (refresh) {
+            dnsRefresh(name, type, key, std::move(lookup));
+            co_return answer;
+        }
+
+        if (leader) {
+            co_return co_await dnsFlight(name, type, key, std::move(lookup), deadline);
+        }
+
+        if (lookup) {
+            // followers are bound by their own deadline, not the leader's
+            auto shared = co_await dns_follower{*lookup, deadline};
+            co_return shared;
+        }
+
+        co_return answer;
+    }
 
     SocketAddress SocketAddress::ipv4FromLiteral(const char *addr, int port)
     {
@@ -124,6 +395,26 @@ namespace suil {
         return addr;
     }
 
+    SocketAddress SocketAddress::unixDomain(const std::string& path)
+    {
+        SocketAddress addr{};
+        auto un = (struct sockaddr_un *) addr._data;
+        if (unlikely(path.empty() || path.size() >= sizeof(un->sun_path))) {
+            un->sun_family = AF_UNSPEC;
+            errno = path.empty()? EINVAL : ENAMETOOLONG;
+            return addr;
+        }
+
+        un->sun_family = AF_UNIX;
+        memcpy(un->sun_path, path.data(), path.size());
+        if (path[0] == '@') {
+            // abstract namespace, the name is not bound to the filesystem
+            un->sun_path[0] = '\0';
+        }
+        errno = 0;
+        return addr;
+    }
+
     int SocketAddress::family() const
     {
         return ((struct sockaddr*)_data)->sa_family;
@@ -131,15 +422,34 @@ namespace suil {
 
     int SocketAddress::size() const
     {
-        return family() == AF_INET?
-               sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6);
+        switch (family()) {
+            case AF_INET:
+                return sizeof(struct sockaddr_in);
+            case AF_UNIX: {
+                auto un = (const struct sockaddr_un *) _data;
+                auto len = strnlen(&un->sun_path[1], sizeof(un->sun_path) - 1);
+                if (un->sun_path[0] != '\0') {
+                    // filesystem path, include the terminating null character
+                    return int(offsetof(struct sockaddr_un, sun_path) + len + 2);
+                }
+                // abstract names are not null terminated, unnamed sockets have no path
+                return int(len == 0? sizeof(sa_family_t) : offsetof(struct sockaddr_un, sun_path) + len + 1);
+            }
+            default:
+                return sizeof(struct sockaddr_in6);
+        }
     }
 
     int SocketAddress::port() const
     {
-        return ntohs(family() == AF_INET?
-               ((struct sockaddr_in*)_data)->sin_port :
-               ((struct sockaddr_in6*)_data)->sin6_port);
+        switch (family()) {
+            case AF_INET:
+                return ntohs(((struct sockaddr_in*)_data)->sin_port);
+            case AF_INET6:
+                return ntohs(((struct sockaddr_in6*)_data)->sin6_port);
+            default:
+                return 0;
+        }
     }
 
     SocketAddress::operator bool() const
@@ -157,6 +467,14 @@ namespace suil {
             char buf[INET6_ADDRSTRLEN];
             return inet_ntop(AF_INET6, &(((struct sockaddr_in6*)_data)->sin6_addr), buf, INET6_ADDRSTRLEN);
         }
+        else if (family() == AF_UNIX) {
+            auto un = (const struct sockaddr_un *) _data;
+            if (un->sun_path[0] != '\0') {
+                return std::string{un->sun_path, strnlen(un->sun_path, sizeof(un->sun_path))};
+            }
+            auto len = strnlen(&un->sun_path[1], sizeof(un->sun_path) - 1);
+            return len == 0? "<unnamed>" : "@" + std::string{&un->sun_path[1], len};
+        }
         return "<invalid>";
     }
 
@@ -250,122 +568,98 @@ namespace suil {
 
     JoinableTask<SocketAddress> SocketAddress::remote(const std::string &name, int port, Mode mode, milliseconds timeout)
     {
-        int rc;
-        SocketAddress addr = ipFromLiteral(name.data(), port, mode);
-        if(errno == 0)
+        auto addrs = co_await remoteAll(name, port, mode, timeout);
+        if (addrs.empty()) {
+            SocketAddress addr{};
+            ((struct sockaddr*) addr._data)->sa_family = AF_UNSPEC;
+            errno = EADDRNOTAVAIL;
             co_return addr;
+        }
 
-        /* Load DNS config files, unless they are already chached. */
-        if(unlikely(!suil_dns_conf)) {
-            suil_dns_conf = dns_resconf_local(&rc);
-            assert(suil_dns_conf);
-            suil_dns_hosts = dns_hosts_local(&rc);
-            assert(suil_dns_hosts);
-            suil_dns_hints = dns_hints_local(suil_dns_conf, &rc);
-            SUIL_ASSERT(suil_dns_hints);
-        }
-        /* Let's do asynchronous DNS query here. */
-        auto opts = dns_opts();
-        struct dns_resolver *resolver = dns_res_open(suil_dns_conf, suil_dns_hosts,
-                                                     suil_dns_hints, nullptr, &opts, &rc);
-        SUIL_ASSERT(resolver);
-        SUIL_ASSERT(port >= 0 && port <= 0xffff);
-        char portstr[8];
-        snprintf(portstr, sizeof(portstr), "%d", port);
-        struct addrinfo hints{};
-        memset(&hints, 0, sizeof(hints));
-        hints.ai_family = PF_UNSPEC;
-        struct dns_addrinfo *ai = dns_ai_open(name.data(), portstr, DNS_T_A, &hints, resolver, &rc);
-        SUIL_ASSERT(ai);
-        dns_res_close(resolver);
-
-        struct addrinfo *ipv4 = nullptr;
-        struct addrinfo *ipv6 = nullptr;
-        struct addrinfo *it = nullptr;
-        auto deadline = afterd(timeout);
+        errno = 0;
+        co_return addrs.front();
+    }
 
-        while (true) {
-            rc = dns_ai_nextent(&it, ai);
-            if (rc == EAGAIN) {
-                int fd = dns_ai_pollfd(ai);
-                SUIL_ASSERT(fd >= 0);
-                auto fdw = co_await fdwait(fd, Event::IN, deadline);
-                if (fdw != Event::esFIRED) {
-                    co_return addr;
-                }
+    Task<std::vector<SocketAddress>> SocketAddress::remoteAll(const std::string &name, int port, Mode mode, milliseconds timeout)
+    {
+        std::vector<SocketAddress> addrs;
+        SocketAddress addr = ipFromLiteral(name.data(), port, mode);
+        if(errno == 0) {
+            addrs.push_back(addr);
+            co_return addrs;
+        }
 
-                continue;
-            }
-            if (rc == ENOENT)
-                break;
+        SUIL_ASSERT(port >= 0 && port <= 0xffff);
+        auto deadline = afterd(timeout);
+        // both families are looked up concurrently
+        Task<DnsAnswer> ipv4Lookup, ipv6Lookup;
+        if (mode != IPV6) {
+            ipv4Lookup = dnsLookup(name, DNS_T_A, deadline);
+        }
+        if (mode != IPV4) {
+            ipv6Lookup = dnsLookup(name, DNS_T_AAAA, deadline);
+        }
 
-            if (!ipv4 && it && it->ai_family == AF_INET) {
-                ipv4 = it;
-            }
-            else if (!ipv6 && it && it->ai_family == AF_INET6) {
-                ipv6 = it;
-            }
-            else {
-                free(it);
-            }
+        std::vector<SocketAddress> ipv4s, ipv6s;
+        int error{0};
+        if (mode != IPV6) {
+            auto answer = co_await ipv4Lookup;
+            ipv4s = std::move(answer.addrs);
+            error = answer.error;
+        }
+        if (mode != IPV4) {
+            auto answer = co_await ipv6Lookup;
+            ipv6s = std::move(answer.addrs);
+            error = error? error : answer.error;
+        }
 
-            if(ipv4 && ipv6)
-                break;
+        for (auto& entry: ipv4s) {
+            ((struct sockaddr_in *) entry._data)->sin_port = htons(port);
+        }
+        for (auto& entry: ipv6s) {
+            ((struct sockaddr_in6 *) entry._data)->sin6_port = htons(port);
         }
 
         switch(mode) {
             case IPV4:
-                if (ipv6) {
-                    free(ipv6);
-                    ipv6 = nullptr;
-                }
+                addrs = std::move(ipv4s);
                 break;
             case IPV6:
-                if(ipv4) {
-                    free (ipv4);
-                    ipv4 = nullptr;
-                }
+                addrs = std::move(ipv6s);
+                break;
+            case IP_PV6:
+                addrs = std::move(ipv6s);
+                addrs.insert(addrs.end(), ipv4s.begin(), ipv4s.end());
                 break;
             case 0:
             case IP_PV4:
-                if (ipv4 && ipv6) {
-                    free(ipv6);
-                    ipv6 = nullptr;
-                }
-                break;
-            case IP_PV6:
-                if (ipv6 && ipv4) {
-                    free(ipv4);
-                    ipv4 = nullptr;
-                }
+                addrs = std::move(ipv4s);
+                addrs.insert(addrs.end(), ipv6s.begin(), ipv6s.end());
                 break;
             default:
                 SUIL_ASSERT(0);
         }
 
-        if  (ipv4) {
-            auto inaddr = (struct sockaddr_in*) addr._data;
-            memcpy(inaddr, ipv4->ai_addr, sizeof (struct sockaddr_in));
-            inaddr->sin_port = htons(port);
-            dns_ai_close(ai);
-            free(ipv4);
-            errno = 0;
-            co_return addr;
+        errno = addrs.empty()? (error == ETIMEDOUT? ETIMEDOUT : EADDRNOTAVAIL) : 0;
+        co_return addrs;
+    }
+
+    Task<std::vector<std::vector<SocketAddress>>> SocketAddress::resolveMany(std::vector<std::string> names, int port, Mode mode, milliseconds timeout)
+    {
+        // all the names are looked up concurrently
+        std::vector<Task<std::vector<SocketAddress>>> lookups;
+        lookups.reserve(names.size());
+        for (auto& name: names) {
+            lookups.push_back(remoteAll(name, port, mode, timeout));
         }
 
-        if (ipv6) {
-            auto inaddr = (struct sockaddr_in6*) addr._data;
-            memcpy(inaddr, ipv6->ai_addr, sizeof (struct sockaddr_in6));
-            inaddr->sin6_port = htons(port);
-            dns_ai_close(ai);
-            free(ipv6);
-            errno = 0;
-            co_return addr;
+        std::vector<std::vector<SocketAddress>> results;
+        results.reserve(names.size());
+        for (auto& lookup: lookups) {
+            results.push_back(co_await lookup);
         }
 
-        dns_ai_close(ai);
-        ((struct sockaddr*) addr._data)->sa_family = AF_UNSPEC;
-        errno = EADDRNOTAVAIL;
-        co_return addr;
+        errno = 0;
+        co_return results;
     }
 }
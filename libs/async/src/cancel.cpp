@@ -0,0 +1,61 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#include "suil/async/cancel.hpp"
+
+namespace suil {
+
+    CancellationSource::CancellationSource()
+        : _state{std::make_shared<detail::cancellation_state>()}
+    {}
+
+    bool CancellationSource::cancel()
+    {
+        std::lock_guard<std::mutex> lk{_state->lock};
+        if (_state->cancelled.exchange(true, std::memory_order_acq_rel)) {
+            return false;
+        }
+
+        while (auto reg = _state->head) {
+            _state->head = reg->_next;
+            reg->_prev = reg->_next = nullptr;
+            reg->_linked = false;
+            // detach() blocks on the lock until the callback returns
+            reg->_callback();
+        }
+        return true;
+    }
+
+    void CancellationRegistration::detach() noexcept
+    {
+        if (_state == nullptr) {
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk{_state->lock};
+            if (_linked) {
+                if (_prev != nullptr) {
+                    _prev->_next = _next;
+                }
+                else {
+                    _state->head = _next;
+                }
+                if (_next != nullptr) {
+                    _next->_prev = _prev;
+                }
+                _prev = _next = nullptr;
+                _linked = false;
+            }
+        }
+        _callback = nullptr;
+        _state.reset();
+    }
+}
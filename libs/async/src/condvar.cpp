@@ -0,0 +1,112 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#include "suil/async/condvar.hpp"
+#include "suil/async/scheduler.hpp"
+
+namespace suil {
+
+    AsyncConditionVariable::~AsyncConditionVariable()
+    {
+        SUIL_ASSERT(_waiters == nullptr && _newWaiters.load(std::memory_order_relaxed) == nullptr);
+    }
+
+    AsyncConditionVariable::wait_operation AsyncConditionVariable::wait(AsyncMutex& mutex) noexcept
+    {
+        return wait_operation{*this, mutex};
+    }
+
+    void AsyncConditionVariable::notifyOne() noexcept
+    {
+        if (_notifications.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            dispatch();
+        }
+    }
+
+    void AsyncConditionVariable::notifyAll() noexcept
+    {
+        _notifyAll.store(true, std::memory_order_release);
+        if (_notifications.fetch_add(1, std::memory_order_acq_rel) == 0) {
+            dispatch();
+        }
+    }
+
+    AsyncConditionVariable::wait_operation *AsyncConditionVariable::pop() noexcept
+    {
+        if (_waiters == nullptr) {
+            // reverse the recently pushed waiters into arrival order
+            auto current = _newWaiters.exchange(nullptr, std::memory_order_acquire);
+            while (current != nullptr) {
+                auto next = current->_next;
+                current->_next = _waiters;
+                _waiters = current;
+                current = next;
+            }
+        }
+
+        auto w = _waiters;
+        if (w != nullptr) {
+            _waiters = w->_next;
+        }
+        return w;
+    }
+
+    void AsyncConditionVariable::dispatch() noexcept
+    {
+        auto count = _notifications.load(std::memory_order_acquire);
+        do {
+            if (_notifyAll.exchange(false, std::memory_order_acq_rel)) {
+                // subsumes the pending single notifications
+                while (auto w = pop()) {
+                    w->wake();
+                }
+            }
+            else {
+                // notifications without waiters are dropped
+                for (uint32 i = 0; i < count; i++) {
+                    auto w = pop();
+                    if (w == nullptr) {
+                        break;
+                    }
+                    w->wake();
+                }
+            }
+
+            count = _notifications.fetch_sub(count, std::memory_order_acq_rel) - count;
+        } while (count != 0);
+    }
+
+    void AsyncConditionVariable::wait_operation::await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        auto id = qid();
+        _awaiter = awaiter;
+        _tid = id < 0? THREAD_ID_ANY : uint16(id);
+
+        auto& cond = _cond;
+        auto& mutex = _mutex;
+        // the waiter must be visible to notifiers before the mutex is released
+        auto next = cond._newWaiters.load(std::memory_order_relaxed);
+        do {
+            _next = next;
+        } while (!cond._newWaiters.compare_exchange_weak(next, this, std::memory_order_release, std::memory_order_relaxed));
+
+        // once notified the waiter may be queued on the mutex and handed the lock
+        // here, it must not be touched after this
+        mutex.unlock();
+    }
+
+    void AsyncConditionVariable::wait_operation::wake() noexcept
+    {
+        if (!_lock.await_suspend(_awaiter)) {
+            // the mutex was free, otherwise the waiter is resumed when unlocked
+            Scheduler::instance().schedule(_awaiter, _tid);
+        }
+    }
+}
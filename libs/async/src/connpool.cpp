@@ -0,0 +1,378 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-22
+ */
+
+#include "suil/async/connpool.hpp"
+#include "suil/async/delay.hpp"
+#include "suil/async/fdwait.hpp"
+#include "suil/async/scheduler.hpp"
+
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+
+namespace suil {
+
+    TcpConnectionPool::TcpConnectionPool(Options opts)
+        : _options{opts}
+    {
+        SUIL_ASSERT(_options.maxTotal > 0);
+        _options.maxIdle = std::min(_options.maxIdle, _options.maxTotal);
+    }
+
+    TcpConnectionPool::~TcpConnectionPool() noexcept
+    {
+        close();
+    }
+
+    TcpConnectionPool::Ptr TcpConnectionPool::create(Options opts)
+    {
+        Ptr pool{new TcpConnectionPool(opts)};
+        // the evictor only holds a weak reference, it exits on the first tick after the pool is gone
+        evictor(pool, opts.evictInterval);
+        return pool;
+    }
+
+    VoidTask<> TcpConnectionPool::evictor(WPtr pool, milliseconds interval)
+    {
+        while (true) {
+            co_await asyncDelay(interval);
+            auto self = pool.lock();
+            if (self == nullptr) {
+                break;
+            }
+
+            self->evict();
+        }
+    }
+
+    std::string TcpConnectionPool::key(const SocketAddress& addr)
+    {
+        return std::string{static_cast<const char *>(addr.raw()), std::size_t(addr.size())};
+    }
+
+    bool TcpConnectionPool::isHealthy(const TcpSocket& sock)
+    {
+        // an idle connection must have nothing to read, a readable connection
+        // was either closed by the peer or has unsolicited data pending
+        char c;
+        auto rc = ::recv(sock.fd(), &c, sizeof(c), MSG_PEEK | MSG_DONTWAIT);
+        return rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+    }
+
+    std::size_t TcpConnectionPool::localIndex()
+    {
+        auto id = qid();
+        return id < 0? Scheduler::instance().threadCount() : std::size_t(id);
+    }
+
+    TcpConnectionPool::Endpoint& TcpConnectionPool::endpoint(const std::string& key)
+    {
+        auto& ep = _endpoints[key];
+        if (ep.idle.empty()) {
+            ep.idle.resize(Scheduler::instance().threadCount() + 1u);
+        }
+        return ep;
+    }
+
+    TcpSocket TcpConnectionPool::popIdle(Endpoint& ep, std::size_t index)
+    {
+        if (ep.nIdle == 0) {
+            return {};
+        }
+
+        // most recently released connection on this thread first, otherwise
+        // steal from another thread
+        auto *list = &ep.idle[index];
+        for (auto i = 0u; list->empty() && i < ep.idle.size(); i++) {
+            list = &ep.idle[i];
+        }
+
+        SUIL_ASSERT(!list->empty());
+        auto sock = std::move(list->back().sock);
+        list->pop_back();
+        ep.nIdle--;
+        return sock;
+    }
+
+    void TcpConnectionPool::grant(Endpoint& ep, TcpSocket&& sock)
+    {
+        // hands either a connection or, when sock is invalid, a connect slot to the first waiter
+        auto waiter = ep.head;
+        SUIL_ASSERT(waiter != nullptr);
+        ep.head = waiter->next;
+        if (ep.head == nullptr) {
+            ep.tail = nullptr;
+        }
+
+        waiter->next = nullptr;
+        waiter->granted = true;
+        waiter->sock = std::move(sock);
+        eventfd_write(waiter->efd, 1);
+    }
+
+    void TcpConnectionPool::unlink(Endpoint& ep, Waiter *waiter)
+    {
+        Waiter *prev{nullptr};
+        for (auto it = ep.head; it != nullptr; prev = it, it = it->next) {
+            if (it != waiter) {
+                continue;
+            }
+
+            if (prev == nullptr) {
+                ep.head = it->next;
+            }
+            else {
+                prev->next = it->next;
+            }
+
+            if (ep.tail == it) {
+                ep.tail = prev;
+            }
+            it->next = nullptr;
+            break;
+        }
+    }
+
+    void TcpConnectionPool::discard(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        auto& ep = endpoint(key);
+        SUIL_ASSERT(ep.total > 0);
+        ep.total--;
+        if (ep.head != nullptr) {
+            // the freed slot goes to the longest waiting coroutine
+            ep.total++;
+            grant(ep, {});
+        }
+    }
+
+    auto TcpConnectionPool::acquire(const SocketAddress& addr, milliseconds timeout) -> Task<TcpSocket>
+    {
+        auto deadline = afterd(timeout);
+        auto k = key(addr);
+        auto index = localIndex();
+        auto tid = qid() < 0? THREAD_ID_ANY : uint16(qid());
+        Waiter waiter{};
+
+        while (true) {
+            TcpSocket sock{};
+            bool mayConnect{false}, mustWait{false};
+            {
+                std::lock_guard<std::mutex> lk{_lock};
+                auto& ep = endpoint(k);
+                if (waiter.granted) {
+                    // woken up by a release, with either a connection or a connect slot
+                    waiter.granted = false;
+                    sock = std::move(waiter.sock);
+                    if (sock) {
+                        _stats.reused++;
+                    }
+                    else if (_closed) {
+                        ep.total--;
+                        errno = ECANCELED;
+                        break;
+                    }
+                    else {
+                        mayConnect = true;
+                    }
+                }
+                else if (_closed) {
+                    errno = ECANCELED;
+                    break;
+                }
+                else if ((sock = popIdle(ep, index))) {
+                    _stats.reused++;
+                }
+                else if (ep.total < _options.maxTotal) {
+                    ep.total++;
+                    mayConnect = true;
+                }
+                else if (waiter.efd != INVALID_FD) {
+                    if (ep.tail == nullptr) {
+                        ep.head = &waiter;
+                    }
+                    else {
+                        ep.tail->next = &waiter;
+                    }
+                    ep.tail = &waiter;
+                    mustWait = true;
+                }
+            }
+
+            if (sock) {
+                if (isHealthy(sock)) {
+                    sock.bindToThread(tid);
+                    if (waiter.efd != INVALID_FD) {
+                        ::close(waiter.efd);
+                    }
+                    co_return std::move(sock);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lk{_lock};
+                    _stats.broken++;
+                }
+                sock.close();
+                discard(k);
+                continue;
+            }
+
+            if (mayConnect) {
+                if (waiter.efd != INVALID_FD) {
+                    ::close(waiter.efd);
+                }
+
+                auto remaining = deadline < 0? DELAY_INF : milliseconds{std::max<int64>(deadline - fastnow(), 1)};
+                auto conn = co_await TcpSocket::connect(addr, tid, remaining);
+                if (!conn) {
+                    auto err = errno;
+                    discard(k);
+                    errno = err;
+                }
+                else {
+                    std::lock_guard<std::mutex> lk{_lock};
+                    _stats.created++;
+                }
+                co_return std::move(conn);
+            }
+
+            if (!mustWait) {
+                // the endpoint is at its limit, retry with a wait handle
+                waiter.efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (waiter.efd == INVALID_FD) {
+                    break;
+                }
+                continue;
+            }
+
+            auto ev = co_await fdwait(waiter.efd, Event::IN, deadline, tid);
+            if (ev == Event::esFIRED) {
+                // the waiter may have to wait again on the same handle
+                eventfd_t count{0};
+                eventfd_read(waiter.efd, &count);
+            }
+            std::lock_guard<std::mutex> lk{_lock};
+            if (!waiter.granted) {
+                unlink(endpoint(k), &waiter);
+                if (ev == Event::esTIMEOUT) {
+                    _stats.timeouts++;
+                    errno = ETIMEDOUT;
+                }
+                break;
+            }
+        }
+
+        auto err = errno;
+        if (waiter.efd != INVALID_FD) {
+            ::close(waiter.efd);
+        }
+        co_return TcpSocket{INVALID_FD, err, tid};
+    }
+
+    void TcpConnectionPool::release(TcpSocket&& sock, bool reusable)
+    {
+        if (!sock.address()) {
+            // not a connection from this pool
+            sock.close();
+            return;
+        }
+
+        auto k = key(sock.address());
+        TcpSocket conn{std::move(sock)};
+        std::unique_lock<std::mutex> lk{_lock};
+        auto it = _endpoints.find(k);
+        if (it == _endpoints.end()) {
+            return;
+        }
+
+        auto& ep = it->second;
+        if (!_closed && reusable && conn) {
+            if (ep.head != nullptr) {
+                // hand over directly, the connection stays counted as checked out
+                grant(ep, std::move(conn));
+                return;
+            }
+
+            if (ep.nIdle < _options.maxIdle) {
+                ep.idle[localIndex()].push_back({std::move(conn), fastnow()});
+                ep.nIdle++;
+                return;
+            }
+        }
+
+        SUIL_ASSERT(ep.total > 0);
+        ep.total--;
+        if (ep.head != nullptr) {
+            ep.total++;
+            grant(ep, {});
+        }
+        lk.unlock();
+        conn.close();
+    }
+
+    void TcpConnectionPool::evict()
+    {
+        std::vector<TcpSocket> expired;
+        {
+            std::lock_guard<std::mutex> lk{_lock};
+            auto before = fastnow() - _options.idleTimeout.count();
+            for (auto it = _endpoints.begin(); it != _endpoints.end();) {
+                auto& ep = it->second;
+                for (auto& list: ep.idle) {
+                    // lists are ordered by release time, oldest first
+                    auto count = 0u;
+                    while (count < list.size() && list[count].since <= before) {
+                        expired.push_back(std::move(list[count++].sock));
+                    }
+                    list.erase(list.begin(), list.begin() + count);
+                    ep.nIdle -= count;
+                    ep.total -= count;
+                    _stats.evicted += count;
+                }
+
+                if (ep.total == 0 && ep.head == nullptr) {
+                    it = _endpoints.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+        // sockets are closed outside the lock
+    }
+
+    void TcpConnectionPool::close()
+    {
+        std::vector<TcpSocket> idle;
+        std::lock_guard<std::mutex> lk{_lock};
+        _closed = true;
+        for (auto& [_, ep]: _endpoints) {
+            for (auto& list: ep.idle) {
+                for (auto& entry: list) {
+                    idle.push_back(std::move(entry.sock));
+                }
+                ep.total -= list.size();
+                list.clear();
+            }
+            ep.nIdle = 0;
+            while (ep.head != nullptr) {
+                // wake up waiters, they will observe the closed pool
+                ep.total++;
+                grant(ep, {});
+            }
+        }
+    }
+
+    TcpConnectionPool::Stats TcpConnectionPool::getStats() const
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        return _stats;
+    }
+}
@@ -16,7 +16,37 @@ namespace suil {
     Delay::Delay(int64_t timeout, uint16_t tid)
         : _tID{tid}
     {
-        _timer.dd = fastnow() + timeout;
+        _timer.dd = fastnowns() + timeout * 1000000;
+    }
+
+    Delay::Delay(nanoseconds timeout, uint16_t tid)
+        : _tID{tid}
+    {
+        _timer.dd = afterdns(timeout);
+    }
+
+    Delay::Delay(nanoseconds timeout, nanoseconds slack, uint16_t tid)
+        : Delay(timeout, tid)
+    {
+        _timer.slack = std::max<int64_t>(slack.count(), 0);
+    }
+
+    Delay::Delay(int64_t timeout, CancellationToken token, uint16_t tid)
+        : Delay(timeout, tid)
+    {
+        _token = std::move(token);
+    }
+
+    Delay::Delay(nanoseconds timeout, CancellationToken token, uint16_t tid)
+        : Delay(timeout, tid)
+    {
+        _token = std::move(token);
+    }
+
+    Delay::Delay(nanoseconds timeout, nanoseconds slack, CancellationToken token, uint16_t tid)
+        : Delay(timeout, slack, tid)
+    {
+        _token = std::move(token);
     }
 
     Delay::Delay(Delay &&other) noexcept
@@ -31,7 +61,9 @@ namespace suil {
             _state = other._state.exchange(tsABANDONED);
             _coro = std::exchange(other._coro, nullptr);
             _tID = std::exchange(other._tID, 0);
+            _owner = std::exchange(other._owner, THREAD_ID_ANY);
             _timer = std::exchange(other._timer, {});
+            _token = std::move(other._token);
         }
 
         return Ego;
@@ -42,10 +74,123 @@ namespace suil {
         SUIL_ASSERT(_state == tsCREATED);
     }
 
-    void Delay::await_suspend(std::coroutine_handle<> coroutine) noexcept
+    bool Delay::await_suspend(std::coroutine_handle<> coroutine) noexcept
     {
         SUIL_ASSERT(_state == tsCREATED);
         _coro = coroutine;
-        Scheduler::instance().schedule(this, _tID);
+        auto scheduled = _registration.attach(_token,
+                                              [this] { Scheduler::instance().cancel(this); },
+                                              [this] { Scheduler::instance().schedule(this, _tID); });
+        if (!scheduled) {
+            // already cancelled, resume as abandoned
+            _state = tsABANDONED;
+        }
+        return scheduled;
+    }
+
+    Alarm::Alarm(std::function<void()> callback)
+        : _callback{std::move(callback)}
+    {}
+
+    Alarm::~Alarm() noexcept
+    {
+        disarm();
+    }
+
+    bool Alarm::arm(int64_t dd, uint16_t tid)
+    {
+        return armns(dd * 1000000, tid);
+    }
+
+    bool Alarm::armns(int64_t dd, uint16_t tid)
+    {
+        auto armed = false;
+        if (!_armed.compare_exchange_strong(armed, true)) {
+            return false;
+        }
+
+        _timer.dd = dd;
+        Scheduler::instance().schedule(this, tid);
+        return true;
+    }
+
+    bool Alarm::disarm()
+    {
+        if (_owner == THREAD_ID_ANY) {
+            // never armed
+            return false;
+        }
+
+        if (Scheduler::instance().cancel(this)) {
+            return true;
+        }
+
+        if (qid() != int16(_owner)) {
+            // the callback might be running on the owner thread
+            while (_running) {
+                std::this_thread::yield();
+            }
+        }
+        return false;
+    }
+
+    Interval::Interval(nanoseconds period, Mode mode, MissedTicks missed, uint16_t tid)
+        : _delay{period, tid},
+          _period{std::max<int64_t>(period.count(), 1)},
+          _mode{mode},
+          _missed{missed}
+    {
+        _next = fastnowns() + _period;
+    }
+
+    Interval::Interval(nanoseconds period, CancellationToken token, Mode mode, MissedTicks missed, uint16_t tid)
+        : _delay{period, std::move(token), tid},
+          _period{std::max<int64_t>(period.count(), 1)},
+          _mode{mode},
+          _missed{missed}
+    {
+        _next = fastnowns() + _period;
+    }
+
+    bool Interval::await_ready() noexcept
+    {
+        if (_delay._token.isCancelled()) {
+            // suspending resumes right away as abandoned
+            return false;
+        }
+        if (std::exchange(_restart, false)) {
+            // fixed delay, the period starts over when the next tick is awaited
+            _next = fastnowns() + _period;
+        }
+        // a tick missed while the awaiter was busy is due right away
+        _due = (_next <= fastnowns());
+        return _due;
+    }
+
+    bool Interval::await_suspend(std::coroutine_handle<> coroutine) noexcept
+    {
+        // the same timer entry is re-armed for every tick
+        _delay._timer.dd = _next;
+        return _delay.await_suspend(coroutine);
+    }
+
+    uint64 Interval::await_resume() noexcept
+    {
+        if (!std::exchange(_due, false) && !_delay.await_resume()) {
+            return 0;
+        }
+
+        uint64 ticks{1};
+        if (_mode == FIXED_DELAY) {
+            _restart = true;
+            return ticks;
+        }
+
+        auto now = fastnowns();
+        if (_missed == SKIP && now >= _next + _period) {
+            ticks += uint64((now - _next) / _period);
+        }
+        _next += int64_t(ticks) * _period;
+        return ticks;
     }
-}
\ No newline at end of file
+}
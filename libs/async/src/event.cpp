@@ -80,7 +80,7 @@ namespace suil {
                 return auto_reset_event_operation{};
             }
         }
-        return auto_reset_event_operation{};
+        return auto_reset_event_operation{*this};
     }
 
     void AutoResetEvent::set() noexcept
@@ -138,9 +138,9 @@ namespace suil {
                 auto waiterToResume = _waiters;
                 _waiters = _waiters->_next;
                 // Put it onto the end of the list of waiters to resume
-                waitersToResume->_next = nullptr;
+                waiterToResume->_next = nullptr;
                 *waitersToResumeEnd = waiterToResume;
-                waitersToResumeEnd = &waitersToResume->_next;
+                waitersToResumeEnd = &waiterToResume->_next;
             }
 
             const auto delta = std::uint64_t(waitersToResumeCount) |
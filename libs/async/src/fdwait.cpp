@@ -30,9 +30,11 @@ namespace suil {
             SUIL_ASSERT(_handle.state == esCREATED);
             _handle.state = other._handle.state.exchange(esABANDONED);
             _handle.tid = std::exchange(other._handle.tid, 0);
+            _handle.owner = std::exchange(other._handle.owner, THREAD_ID_ANY);
             _handle.fd = std::exchange(other._handle.fd, INVALID_FD);
             _handle.timerHandle = std::exchange(other._handle.timerHandle, {});
             _handle.coro = std::exchange(other._handle.coro, nullptr);
+            _token = std::move(other._token);
         }
 
         return *this;
@@ -44,10 +46,18 @@ namespace suil {
         SUIL_ASSERT(_handle.state == esCREATED);
     }
 
-    void Event::await_suspend(std::coroutine_handle<> coroutine) noexcept
+    bool Event::await_suspend(std::coroutine_handle<> coroutine) noexcept
     {
         SUIL_ASSERT(_handle.state == esCREATED);
         _handle.coro = coroutine;
-        Scheduler::instance().schedule(this, _handle.tid);
+        // scheduling with the token locked guarantees that a cancellation sees the event scheduled
+        auto scheduled = _registration.attach(_token,
+                                              [this] { Scheduler::instance().cancel(this); },
+                                              [this] { Scheduler::instance().schedule(this, _handle.tid); });
+        if (!scheduled) {
+            // already cancelled
+            _handle.state = esCANCELLED;
+        }
+        return scheduled;
     }
 }
\ No newline at end of file
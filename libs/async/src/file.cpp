@@ -0,0 +1,533 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-23
+ */
+
+#include "suil/async/file.hpp"
+#include "suil/async/fdwait.hpp"
+#include "suil/async/scheduler.hpp"
+
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/io_uring.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+
+namespace suil {
+
+    namespace {
+
+        struct io_request {
+            std::coroutine_handle<> coro{nullptr};
+            std::atomic<std::size_t> remaining{0};
+            uint16 tid{THREAD_ID_ANY};
+        };
+
+        struct io_slot {
+            io_request *req{nullptr};
+            FileOp *op{nullptr};
+            int fd{INVALID_FD};
+            struct iovec iov{};
+        };
+
+        void execute(io_slot& slot)
+        {
+            auto op = slot.op;
+            ssize_t rc;
+            do {
+                switch (op->op) {
+                    case FileOp::READ:
+                        rc = ::pread(slot.fd, op->buf.data(), op->buf.size(), op->offset);
+                        break;
+                    case FileOp::WRITE:
+                        rc = ::pwrite(slot.fd, op->buf.data(), op->buf.size(), op->offset);
+                        break;
+                    case FileOp::FSYNC:
+                        rc = ::fsync(slot.fd);
+                        break;
+                    case FileOp::FDATASYNC:
+                        rc = ::fdatasync(slot.fd);
+                        break;
+                    case FileOp::FALLOCATE:
+                        rc = ::fallocate(slot.fd, op->mode, op->offset, op->length);
+                        break;
+                    default:
+                        rc = -1;
+                        errno = EINVAL;
+                        break;
+                }
+            } while (rc < 0 && errno == EINTR);
+
+            op->result = rc < 0? -errno : int(rc);
+        }
+
+        /**
+         * Executes file operations on dedicated threads, used when io_uring is
+         * not available. Completed requests are resumed on their async thread.
+         */
+        class io_pool {
+        public:
+            static io_pool& instance()
+            {
+                // never destroyed, the workers are blocked on the queue at exit
+                static auto *pool = new io_pool();
+                return *pool;
+            }
+
+            void post(std::span<io_slot> slots)
+            {
+                {
+                    std::lock_guard<std::mutex> lk{_lock};
+                    for (auto& slot: slots) {
+                        _queue.push_back(&slot);
+                    }
+                }
+
+                if (slots.size() == 1) {
+                    _cond.notify_one();
+                }
+                else {
+                    _cond.notify_all();
+                }
+            }
+
+        private:
+            io_pool()
+            {
+                for (auto i = 0u; i < SUIL_ASYNC_FILE_IO_THREADS; i++) {
+                    std::thread{[this] { run(); }}.detach();
+                }
+            }
+
+            void run()
+            {
+                while (true) {
+                    io_slot *slot;
+                    {
+                        std::unique_lock<std::mutex> lk{_lock};
+                        _cond.wait(lk, [this] { return !_queue.empty(); });
+                        slot = _queue.front();
+                        _queue.pop_front();
+                    }
+
+                    execute(*slot);
+                    // the slot belongs to the suspended coroutine, it may not be used once the
+                    // request is complete
+                    auto req = slot->req;
+                    if (req->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        Scheduler::instance().schedule(req->coro, req->tid);
+                    }
+                }
+            }
+
+            std::mutex _lock{};
+            std::condition_variable _cond{};
+            std::deque<io_slot *> _queue{};
+        };
+
+#if SUIL_ASYNC_FILE_URING
+        /**
+         * An io_uring instance owned by an async thread. Completions are signalled
+         * on an eventfd which is polled by a reaper coroutine on the same thread.
+         */
+        class io_ring {
+        public:
+            static io_ring *local()
+            {
+                static std::atomic_bool Unsupported{false};
+                static __thread io_ring *Ring{nullptr};
+
+                if (Ring == nullptr && qid() >= 0 && !Unsupported) {
+                    auto ring = new io_ring(uint16(qid()));
+                    if (!ring->setup()) {
+                        // e.g. kernel too old or io_uring disabled
+                        delete ring;
+                        Unsupported = true;
+                        return nullptr;
+                    }
+                    Ring = ring;
+                    ring->reaper();
+                }
+                return Ring;
+            }
+
+            ~io_ring() noexcept
+            {
+                if (_sqes != nullptr) {
+                    munmap(_sqes, _sqesSize);
+                }
+                if (_cqRing != nullptr && _cqRing != _sqRing) {
+                    munmap(_cqRing, _cqSize);
+                }
+                if (_sqRing != nullptr) {
+                    munmap(_sqRing, _sqSize);
+                }
+                if (_efd != INVALID_FD) {
+                    ::close(_efd);
+                }
+                if (_fd != INVALID_FD) {
+                    ::close(_fd);
+                }
+            }
+
+            bool submit(std::span<io_slot> slots)
+            {
+                auto tail = *_sqTail;
+                auto free = _sqEntries - (tail - __atomic_load_n(_sqHead, __ATOMIC_ACQUIRE));
+                // never have more requests in flight than the completion queue can hold
+                if (slots.size() > free || _inflight + slots.size() > _cqEntries) {
+                    return false;
+                }
+
+                for (auto& slot: slots) {
+                    auto index = tail++ & *_sqMask;
+                    prepare(_sqes[index], slot);
+                    _sqArray[index] = index;
+                }
+
+                __atomic_store_n(_sqTail, tail, __ATOMIC_RELEASE);
+                auto submitted = flush(unsigned(slots.size()));
+                _inflight += submitted;
+                if (submitted == slots.size()) {
+                    return true;
+                }
+
+                // the kernel refused the rest (e.g. EAGAIN, ENOMEM), there might be no
+                // completion to retry them after. The ring is only entered from this
+                // thread, the entries it did not consume can be taken back
+                __atomic_store_n(_sqTail, tail - unsigned(slots.size() - submitted), __ATOMIC_RELEASE);
+                if (submitted == 0) {
+                    return false;
+                }
+                io_pool::instance().post(slots.subspan(submitted));
+                return true;
+            }
+
+        private:
+            explicit io_ring(uint16 tid)
+                : _tid{tid}
+            {}
+
+            static void prepare(struct io_uring_sqe& sqe, io_slot& slot)
+            {
+                auto op = slot.op;
+                memset(&sqe, 0, sizeof(sqe));
+                sqe.fd = slot.fd;
+                sqe.user_data = uint64(uintptr_t(&slot));
+                switch (op->op) {
+                    case FileOp::READ:
+                    case FileOp::WRITE:
+                        slot.iov = {op->buf.data(), op->buf.size()};
+                        sqe.opcode = op->op == FileOp::READ? IORING_OP_READV : IORING_OP_WRITEV;
+                        sqe.addr = uint64(uintptr_t(&slot.iov));
+                        sqe.len = 1;
+                        sqe.off = uint64(op->offset);
+                        break;
+                    case FileOp::FSYNC:
+                    case FileOp::FDATASYNC:
+                        sqe.opcode = IORING_OP_FSYNC;
+                        sqe.fsync_flags = op->op == FileOp::FDATASYNC? IORING_FSYNC_DATASYNC : 0;
+                        break;
+                    case FileOp::FALLOCATE:
+                        sqe.opcode = IORING_OP_FALLOCATE;
+                        sqe.off = uint64(op->offset);
+                        sqe.addr = uint64(op->length);
+                        sqe.len = uint32(op->mode);
+                        break;
+                    default:
+                        sqe.opcode = IORING_OP_NOP;
+                        break;
+                }
+            }
+
+            bool setup()
+            {
+                struct io_uring_params params{};
+                _fd = int(syscall(__NR_io_uring_setup, SUIL_ASYNC_FILE_RING_ENTRIES, &params));
+                if (_fd < 0) {
+                    _fd = INVALID_FD;
+                    return false;
+                }
+
+                _sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+                _cqSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+                _sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+                bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+                if (single) {
+                    _sqSize = _cqSize = std::max(_sqSize, _cqSize);
+                }
+
+                auto map = [this](std::size_t size, off_t offset) -> void * {
+                    auto ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, offset);
+                    return ptr == MAP_FAILED? nullptr : ptr;
+                };
+
+                _sqRing = static_cast<char *>(map(_sqSize, IORING_OFF_SQ_RING));
+                if (_sqRing == nullptr) {
+                    return false;
+                }
+                _cqRing = single? _sqRing : static_cast<char *>(map(_cqSize, IORING_OFF_CQ_RING));
+                if (_cqRing == nullptr) {
+                    return false;
+                }
+                _sqes = static_cast<struct io_uring_sqe *>(map(_sqesSize, IORING_OFF_SQES));
+                if (_sqes == nullptr) {
+                    return false;
+                }
+
+                _sqHead = reinterpret_cast<unsigned *>(_sqRing + params.sq_off.head);
+                _sqTail = reinterpret_cast<unsigned *>(_sqRing + params.sq_off.tail);
+                _sqMask = reinterpret_cast<unsigned *>(_sqRing + params.sq_off.ring_mask);
+                _sqArray = reinterpret_cast<unsigned *>(_sqRing + params.sq_off.array);
+                _sqEntries = params.sq_entries;
+                _cqHead = reinterpret_cast<unsigned *>(_cqRing + params.cq_off.head);
+                _cqTail = reinterpret_cast<unsigned *>(_cqRing + params.cq_off.tail);
+                _cqMask = reinterpret_cast<unsigned *>(_cqRing + params.cq_off.ring_mask);
+                _cqes = reinterpret_cast<struct io_uring_cqe *>(_cqRing + params.cq_off.cqes);
+                _cqEntries = params.cq_entries;
+
+                _efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if (_efd == INVALID_FD) {
+                    return false;
+                }
+                return syscall(__NR_io_uring_register, _fd, IORING_REGISTER_EVENTFD, &_efd, 1) == 0;
+            }
+
+            unsigned flush(unsigned pending)
+            {
+                // returns the number of entries consumed by the kernel
+                unsigned submitted{0};
+                while (submitted < pending) {
+                    auto rc = syscall(__NR_io_uring_enter, _fd, pending - submitted, 0, 0, nullptr, 0);
+                    if (rc < 0 && errno == EINTR) {
+                        continue;
+                    }
+                    if (rc <= 0) {
+                        break;
+                    }
+                    submitted += unsigned(rc);
+                }
+                return submitted;
+            }
+
+            VoidTask<> reaper()
+            {
+                std::vector<io_request *> done;
+                while (true) {
+                    eventfd_t count;
+                    eventfd_read(_efd, &count);
+
+                    auto head = *_cqHead;
+                    auto tail = __atomic_load_n(_cqTail, __ATOMIC_ACQUIRE);
+                    for (; head != tail; head++) {
+                        auto& cqe = _cqes[head & *_cqMask];
+                        auto slot = reinterpret_cast<io_slot *>(uintptr_t(cqe.user_data));
+                        slot->op->result = cqe.res;
+                        // the other slots of the request may have completed on the pool
+                        if (slot->req->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                            done.push_back(slot->req);
+                        }
+                        _inflight--;
+                    }
+                    __atomic_store_n(_cqHead, head, __ATOMIC_RELEASE);
+
+                    // completed requests are resumed after the queue has been released
+                    for (auto req: done) {
+                        req->coro.resume();
+                    }
+                    done.clear();
+
+                    co_await fdwait(_efd, Event::IN, -1, _tid);
+                }
+            }
+
+            uint16 _tid{0};
+            int _fd{INVALID_FD};
+            int _efd{INVALID_FD};
+            char *_sqRing{nullptr};
+            char *_cqRing{nullptr};
+            struct io_uring_sqe *_sqes{nullptr};
+            std::size_t _sqSize{0}, _cqSize{0}, _sqesSize{0};
+            unsigned *_sqHead{nullptr}, *_sqTail{nullptr}, *_sqMask{nullptr}, *_sqArray{nullptr};
+            unsigned *_cqHead{nullptr}, *_cqTail{nullptr}, *_cqMask{nullptr};
+            struct io_uring_cqe *_cqes{nullptr};
+            unsigned _sqEntries{0}, _cqEntries{0};
+            std::size_t _inflight{0};
+        };
+#endif
+
+        struct file_io {
+            file_io(int fd, std::span<FileOp> ops)
+            {
+                if (ops.size() > 1) {
+                    _many.resize(ops.size());
+                    _slots = _many;
+                }
+                else {
+                    _slots = {&_single, ops.size()};
+                }
+
+                for (auto i = 0u; i < ops.size(); i++) {
+                    _slots[i].op = &ops[i];
+                    _slots[i].fd = fd;
+                    _slots[i].req = &_req;
+                }
+            }
+
+            DISABLE_COPY(file_io);
+            DISABLE_MOVE(file_io);
+
+            bool await_ready() const noexcept { return _slots.empty(); }
+
+            void await_suspend(std::coroutine_handle<> coro) noexcept
+            {
+                _req.coro = coro;
+                _req.tid = qid() < 0? THREAD_ID_ANY : uint16(qid());
+                _req.remaining = _slots.size();
+#if SUIL_ASYNC_FILE_URING
+                auto ring = io_ring::local();
+                if (ring != nullptr && ring->submit(_slots)) {
+                    return;
+                }
+#endif
+                io_pool::instance().post(_slots);
+            }
+
+            void await_resume() const noexcept {}
+
+        private:
+            io_request _req{};
+            io_slot _single{};
+            std::vector<io_slot> _many{};
+            std::span<io_slot> _slots{};
+        };
+    }
+
+    AlignedBuffer::AlignedBuffer(std::size_t size, std::size_t alignment)
+        : _size{roundUp(size, alignment)}
+    {
+        SUIL_ASSERT((alignment & (alignment - 1)) == 0);
+        if (posix_memalign(reinterpret_cast<void **>(&_data), alignment, _size) != 0) {
+            throw std::bad_alloc{};
+        }
+    }
+
+    AlignedBuffer::~AlignedBuffer() noexcept
+    {
+        free(_data);
+    }
+
+    AlignedBuffer::AlignedBuffer(AlignedBuffer&& other) noexcept
+        : _data{std::exchange(other._data, nullptr)},
+          _size{std::exchange(other._size, 0)}
+    {}
+
+    AlignedBuffer& AlignedBuffer::operator=(AlignedBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            free(_data);
+            _data = std::exchange(other._data, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return Ego;
+    }
+
+    AsyncFile::~AsyncFile() noexcept
+    {
+        close();
+    }
+
+    AsyncFile::AsyncFile(AsyncFile&& other) noexcept
+        : _fd{std::exchange(other._fd, INVALID_FD)}
+    {}
+
+    AsyncFile& AsyncFile::operator=(AsyncFile&& other) noexcept
+    {
+        if (this != &other) {
+            close();
+            _fd = std::exchange(other._fd, INVALID_FD);
+        }
+        return Ego;
+    }
+
+    AsyncFile AsyncFile::open(const std::string& path, int flags, mode_t mode)
+    {
+        int fd = ::open(path.c_str(), flags | O_CLOEXEC, mode);
+        return AsyncFile{fd < 0? INVALID_FD : fd};
+    }
+
+    void AsyncFile::close()
+    {
+        if (_fd != INVALID_FD) {
+            ::close(_fd);
+            _fd = INVALID_FD;
+        }
+    }
+
+    auto AsyncFile::pread(std::span<char> buf, off_t offset) -> Task<int>
+    {
+        FileOp op{.op = FileOp::READ, .buf = buf, .offset = offset};
+        co_return co_await submit({&op, 1}) == 0? op.result : -1;
+    }
+
+    auto AsyncFile::pwrite(std::span<const char> buf, off_t offset) -> Task<int>
+    {
+        FileOp op{.op = FileOp::WRITE, .buf = {const_cast<char *>(buf.data()), buf.size()}, .offset = offset};
+        co_return co_await submit({&op, 1}) == 0? op.result : -1;
+    }
+
+    auto AsyncFile::fsync(bool dataOnly) -> Task<int>
+    {
+        FileOp op{.op = dataOnly? FileOp::FDATASYNC : FileOp::FSYNC};
+        co_return co_await submit({&op, 1});
+    }
+
+    auto AsyncFile::fallocate(off_t offset, off_t length, int mode) -> Task<int>
+    {
+        FileOp op{.op = FileOp::FALLOCATE, .offset = offset, .length = length, .mode = mode};
+        co_return co_await submit({&op, 1});
+    }
+
+    auto AsyncFile::submit(std::span<FileOp> ops) -> Task<int>
+    {
+        if (_fd == INVALID_FD) {
+            errno = EBADF;
+            co_return -1;
+        }
+
+        co_await file_io{_fd, ops};
+
+        for (auto& op: ops) {
+            if (op.result < 0) {
+                errno = -op.result;
+                co_return -1;
+            }
+        }
+        errno = 0;
+        co_return 0;
+    }
+
+    bool AsyncFile::hasUring()
+    {
+#if SUIL_ASYNC_FILE_URING
+        return io_ring::local() != nullptr;
+#else
+        return false;
+#endif
+    }
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#include "suil/async/detail/frame_pool.hpp"
+
+#include <new>
+
+namespace suil::detail {
+
+    namespace {
+
+        constexpr std::size_t GRANULARITY{SUIL_ASYNC_FRAME_POOL_GRANULARITY};
+        constexpr std::size_t SIZE_CLASSES{(SUIL_ASYNC_FRAME_POOL_MAX_FRAME + GRANULARITY - 1) / GRANULARITY};
+
+        struct free_frame {
+            free_frame *next;
+        };
+
+        struct frame_cache {
+            ~frame_cache()
+            {
+                for (auto& head: free) {
+                    while (head != nullptr) {
+                        ::operator delete(std::exchange(head, head->next));
+                    }
+                }
+            }
+
+            free_frame *free[SIZE_CLASSES]{};
+            uint32 count[SIZE_CLASSES]{};
+        };
+
+        thread_local frame_cache Cache{};
+
+        inline std::size_t sizeClass(std::size_t size) noexcept
+        {
+            return (size + GRANULARITY - 1) / GRANULARITY - 1;
+        }
+    }
+
+    void *frame_pool::allocate(std::size_t size)
+    {
+        auto cls = sizeClass(size);
+        if (cls >= SIZE_CLASSES) {
+            return ::operator new(size);
+        }
+
+        auto& cache = Cache;
+        if (auto frame = cache.free[cls]) {
+            cache.free[cls] = frame->next;
+            cache.count[cls]--;
+            return frame;
+        }
+        return ::operator new((cls + 1) * GRANULARITY);
+    }
+
+    void frame_pool::deallocate(void *frame, std::size_t size) noexcept
+    {
+        auto cls = sizeClass(size);
+        auto& cache = Cache;
+        if (cls >= SIZE_CLASSES || cache.count[cls] >= SUIL_ASYNC_FRAME_POOL_CACHED) {
+            ::operator delete(frame);
+            return;
+        }
+
+        auto block = static_cast<free_frame *>(frame);
+        block->next = cache.free[cls];
+        cache.free[cls] = block;
+        cache.count[cls]++;
+    }
+}
@@ -0,0 +1,143 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#include "suil/async/latch.hpp"
+
+namespace suil {
+
+    AsyncLatch::AsyncLatch(int64 count) noexcept
+        : _count{count}
+    {
+        if (count <= 0) {
+            _state.store(this, std::memory_order_relaxed);
+        }
+    }
+
+    void AsyncLatch::countDown(int64 n) noexcept
+    {
+        auto count = _count.fetch_sub(n, std::memory_order_acq_rel);
+        if (count <= 0 || count > n) {
+            // already released or still counting
+            return;
+        }
+
+        auto const releasedState = static_cast<void *>(this);
+        auto current = static_cast<detail::intrusive_waiter *>(_state.exchange(releasedState, std::memory_order_acq_rel));
+        while (current != nullptr) {
+            auto next = current->next;
+            current->resume();
+            current = next;
+        }
+    }
+
+    bool AsyncLatch::tryWait() const noexcept
+    {
+        return _state.load(std::memory_order_acquire) == static_cast<const void *>(this);
+    }
+
+    AsyncLatch::wait_operation AsyncLatch::wait() noexcept
+    {
+        return wait_operation{*this};
+    }
+
+    AsyncLatch::wait_operation AsyncLatch::operator co_await() noexcept
+    {
+        return wait_operation{*this};
+    }
+
+    AsyncLatch::wait_operation AsyncLatch::arriveAndWait(int64 n) noexcept
+    {
+        countDown(n);
+        return wait_operation{*this};
+    }
+
+    bool AsyncLatch::wait_operation::await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        auto const releasedState = static_cast<void *>(&_latch);
+        _waiter.park(awaiter);
+
+        auto oldState = _latch._state.load(std::memory_order_acquire);
+        do {
+            if (oldState == releasedState) {
+                return false;
+            }
+            _waiter.next = static_cast<detail::intrusive_waiter *>(oldState);
+        } while (!_latch._state.compare_exchange_weak(
+                    oldState,
+                    static_cast<void *>(&_waiter),
+                    std::memory_order_release,
+                    std::memory_order_acquire));
+
+        return true;
+    }
+
+    AsyncBarrier::AsyncBarrier(int64 count, std::function<void()> completion) noexcept
+        : _expected{count},
+          _remaining{count},
+          _completion{std::move(completion)}
+    {
+        SUIL_ASSERT(count > 0);
+    }
+
+    AsyncBarrier::arrive_operation AsyncBarrier::arriveAndWait() noexcept
+    {
+        return arrive_operation{*this};
+    }
+
+    void AsyncBarrier::arriveAndDrop()
+    {
+        _expected.fetch_sub(1, std::memory_order_acq_rel);
+        arrive(nullptr);
+    }
+
+    bool AsyncBarrier::arrive(detail::intrusive_waiter *w)
+    {
+        if (w != nullptr) {
+            // the waiter must be on the list before the arrival is counted, the
+            // last participant to arrive collects the list
+            detail::intrusive_waiter::push(_waiters, w);
+        }
+
+        if (_remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+            return false;
+        }
+
+        complete(w);
+        return true;
+    }
+
+    void AsyncBarrier::complete(detail::intrusive_waiter *self)
+    {
+        // every participant has arrived and is parked, none of them can arrive at
+        // the next phase before being resumed below
+        auto current = _waiters.exchange(nullptr, std::memory_order_acquire);
+        if (_completion) {
+            _completion();
+        }
+
+        _remaining.store(_expected.load(std::memory_order_acquire), std::memory_order_relaxed);
+        _phase.fetch_add(1, std::memory_order_release);
+
+        while (current != nullptr) {
+            auto next = current->next;
+            if (current != self) {
+                current->resume();
+            }
+            current = next;
+        }
+    }
+
+    bool AsyncBarrier::arrive_operation::await_suspend(std::coroutine_handle<> awaiter)
+    {
+        _waiter.park(awaiter);
+        // the last participant to arrive does not suspend
+        return !_barrier.arrive(&_waiter);
+    }
+}
@@ -29,9 +29,51 @@
  */
 
 #include "suil/async/mutex.hpp"
+#include "suil/async/scheduler.hpp"
 
 namespace suil {
 
+    struct AsyncMutex::cancellable_lock_operation::waiter final : AsyncMutex::lock_operation {
+        typedef enum : uint8 {
+            WAITING,
+            ACQUIRED,
+            CANCELLED
+        } Status;
+
+        explicit waiter(AsyncMutex& mutex) noexcept
+            : lock_operation{mutex}
+        {
+            _cancellable = true;
+        }
+
+        bool acquire() noexcept
+        {
+            auto expected = WAITING;
+            return status.compare_exchange_strong(expected, ACQUIRED, std::memory_order_acq_rel);
+        }
+
+        void cancel() noexcept
+        {
+            auto expected = WAITING;
+            if (status.compare_exchange_strong(expected, CANCELLED, std::memory_order_acq_rel)) {
+                // invoked with the token locked, never resume inline
+                Scheduler::instance().schedule(_waiter, tid);
+            }
+        }
+
+        void release() noexcept
+        {
+            if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete this;
+            }
+        }
+
+        std::atomic<Status> status{WAITING};
+        // one reference for the mutex and one for the lock operation
+        std::atomic<uint8> refs{2};
+        uint16 tid{THREAD_ID_ANY};
+    };
+
     AsyncMutex::~AsyncMutex()
     {
         auto state = _state.load(std::memory_order_relaxed);
@@ -53,6 +95,11 @@ namespace suil {
         return  AsyncMutex::lock_operation{ *this };
     }
 
+    AsyncMutex::cancellable_lock_operation AsyncMutex::lockAsync(CancellationToken token) noexcept
+    {
+        return AsyncMutex::cancellable_lock_operation{ *this, std::move(token) };
+    }
+
     AsyncMutex::scoped_lock_operation AsyncMutex::scopedLockAsync() noexcept
     {
         return AsyncMutex::scoped_lock_operation{ *this };
@@ -62,6 +109,23 @@ namespace suil {
     {
         SUIL_ASSERT(_state.load(std::memory_order_relaxed) != NOT_LOCKED);
 
+        while (true) {
+            if (auto waiter = next()) {
+                if (auto coro = waiter->acquire()) {
+                    // resume the waiter
+                    coro.resume();
+                    return;
+                }
+                // the waiter gave up, hand the lock over to the next one
+                continue;
+            }
+            // released
+            return;
+        }
+    }
+
+    AsyncMutex::lock_operation *AsyncMutex::next()
+    {
         auto waitersHeader = _waiters;
         if (_waiters == nullptr) {
             auto oldState = LOCKED_NO_WAITERS;
@@ -70,7 +134,7 @@ namespace suil {
                                                                      std::memory_order_release,
                                                                      std::memory_order_relaxed);
             if (lockReleased) {
-                return;
+                return nullptr;
             }
 
             oldState = _state.exchange(LOCKED_NO_WAITERS, std::memory_order_acquire);
@@ -88,8 +152,21 @@ namespace suil {
         SUIL_ASSERT(waitersHeader != nullptr);
         // remove the next waiting coroutine
         _waiters = waitersHeader->_next;
-        // resume the waiter
-        waitersHeader->_waiter.resume();
+        return waitersHeader;
+    }
+
+    std::coroutine_handle<> AsyncMutex::lock_operation::acquire() noexcept
+    {
+        if (!_cancellable) {
+            return _waiter;
+        }
+
+        auto self = static_cast<cancellable_lock_operation::waiter *>(this);
+        auto coro = _waiter;
+        auto acquired = self->acquire();
+        // the mutex is done with the waiter
+        self->release();
+        return acquired? coro : nullptr;
     }
 
     bool AsyncMutex::lock_operation::await_suspend(std::coroutine_handle<> awaiter) noexcept
@@ -122,4 +199,52 @@ namespace suil {
         }
     }
 
-}
\ No newline at end of file
+
+    AsyncMutex::cancellable_lock_operation::~cancellable_lock_operation() noexcept
+    {
+        if (_waiter != nullptr) {
+            _waiter->release();
+        }
+    }
+
+    bool AsyncMutex::cancellable_lock_operation::await_suspend(std::coroutine_handle<> awaiter) noexcept
+    {
+        if (_token.isCancelled()) {
+            return false;
+        }
+
+        if (_mutex.tryLock()) {
+            _acquired = true;
+            return false;
+        }
+
+        auto id = qid();
+        auto w = new waiter(_mutex);
+        w->tid = id < 0? THREAD_ID_ANY : uint16(id);
+        _waiter = w;
+
+        // joining the waiters with the token locked guarantees that a cancellation finds the waiter
+        bool suspended{false};
+        auto attached = _registration.attach(_token,
+                                             [w] { w->cancel(); },
+                                             [w, awaiter, &suspended] { suspended = w->lock_operation::await_suspend(awaiter); });
+        if (!suspended) {
+            // either cancelled or acquired without waiting, the waiter never joined the mutex's list
+            _acquired = attached;
+            _waiter = nullptr;
+            delete w;
+        }
+        return suspended;
+    }
+
+    bool AsyncMutex::cancellable_lock_operation::await_resume() noexcept
+    {
+        _registration.detach();
+        if (_waiter != nullptr) {
+            _acquired = _waiter->status.load(std::memory_order_acquire) == waiter::ACQUIRED;
+            _waiter->release();
+            _waiter = nullptr;
+        }
+        return _acquired;
+    }
+}
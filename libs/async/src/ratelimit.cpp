@@ -0,0 +1,148 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#include "suil/async/ratelimit.hpp"
+#include "suil/async/scheduler.hpp"
+
+#include <cmath>
+
+namespace suil {
+
+    AsyncRateLimiter::AsyncRateLimiter(double rate, uint64 burst)
+        : _rate{rate},
+          _burst{double(burst)},
+          _tokens{double(burst)},
+          _refilled{fastnow()},
+          _alarm{[this] {
+              std::lock_guard<std::mutex> lk{_lock};
+              dispatch();
+          }}
+    {
+        SUIL_ASSERT(rate > 0 && burst > 0);
+    }
+
+    AsyncRateLimiter::~AsyncRateLimiter()
+    {
+        _alarm.disarm();
+        SUIL_ASSERT(_waiters.empty());
+    }
+
+    void AsyncRateLimiter::refill(int64 now)
+    {
+        if (now > _refilled) {
+            _tokens = std::min(_burst, _tokens + double(now - _refilled) * _rate / 1000.0);
+            _refilled = now;
+        }
+    }
+
+    bool AsyncRateLimiter::take(uint64 n, int64 now)
+    {
+        // must be called with the lock held, waiting coroutines are served first
+        refill(now);
+        if (_waiters.empty() && double(n) <= _tokens) {
+            _tokens -= double(n);
+            _acquired++;
+            return true;
+        }
+        return false;
+    }
+
+    bool AsyncRateLimiter::tryAcquire(uint64 n)
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        return take(n, fastnow());
+    }
+
+    AsyncRateLimiter::acquire_operation AsyncRateLimiter::acquire(uint64 n, milliseconds timeout) noexcept
+    {
+        return acquire_operation{*this, n, afterd(timeout)};
+    }
+
+    void AsyncRateLimiter::dispatch()
+    {
+        // must be called with the lock held
+        auto now = fastnow();
+        refill(now);
+        while (!_waiters.empty() && double(_waiters.head->count) <= _tokens) {
+            _tokens -= double(_waiters.head->count);
+            _acquired++;
+            _waiters.grant();
+        }
+
+        if (!_waiters.empty()) {
+            // go off when the head of the queue can be served. The head changes when a
+            // waiter times out and the new one may need fewer tokens, an alarm armed for
+            // a later deadline is therefore moved. An alarm that cannot be cancelled is
+            // going off and dispatches again.
+            auto deficit = double(_waiters.head->count) - _tokens;
+            auto dd = now + std::max<int64>(int64(std::ceil(deficit * 1000.0 / _rate)), 1);
+            if (_alarm.isArmed() && dd < _alarm.deadline()) {
+                Scheduler::instance().cancel(&_alarm);
+            }
+            _alarm.arm(dd);
+        }
+    }
+
+    double AsyncRateLimiter::available()
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        refill(fastnow());
+        return _tokens;
+    }
+
+    std::size_t AsyncRateLimiter::waiting() const
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        return _waiters.size;
+    }
+
+    WaitStats AsyncRateLimiter::getStats() const
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        auto stats = _waiters.stats;
+        stats.acquired = _acquired;
+        return stats;
+    }
+
+    bool AsyncRateLimiter::acquire_operation::await_suspend(std::coroutine_handle<> coroutine)
+    {
+        std::lock_guard<std::mutex> lk{_limiter._lock};
+        if (double(_waiter.count) > _limiter._burst) {
+            // can never be served
+            return false;
+        }
+
+        if (_limiter.take(_waiter.count, fastnow())) {
+            _acquired = true;
+            return false;
+        }
+
+        _suspended = true;
+        _limiter._waiters.park(_waiter, coroutine, _dd);
+        _limiter.dispatch();
+        return true;
+    }
+
+    bool AsyncRateLimiter::acquire_operation::await_resume()
+    {
+        if (!_suspended) {
+            return _acquired;
+        }
+
+        std::lock_guard<std::mutex> lk{_limiter._lock};
+        if (_limiter._waiters.resumed(_waiter)) {
+            return true;
+        }
+
+        // the next waiter might need fewer tokens
+        _limiter.dispatch();
+        return false;
+    }
+}
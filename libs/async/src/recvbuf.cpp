@@ -0,0 +1,104 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-20
+ */
+
+#include "suil/async/recvbuf.hpp"
+
+namespace suil {
+
+    static __thread RecvBufferPool *LocalPool{nullptr};
+
+    RecvBuffer::RecvBuffer(RecvBuffer&& other) noexcept
+        : _block{std::exchange(other._block, nullptr)},
+          _size{std::exchange(other._size, 0)}
+    {}
+
+    RecvBuffer& RecvBuffer::operator=(RecvBuffer&& other) noexcept
+    {
+        if (this != &other) {
+            release();
+            _block = std::exchange(other._block, nullptr);
+            _size = std::exchange(other._size, 0);
+        }
+        return Ego;
+    }
+
+    void RecvBuffer::release() noexcept
+    {
+        if (_block != nullptr) {
+            _block->owner->giveBack(std::exchange(_block, nullptr));
+            _size = 0;
+        }
+    }
+
+    RecvBufferPool& RecvBufferPool::local()
+    {
+        if (unlikely(LocalPool == nullptr)) {
+            LocalPool = new RecvBufferPool();
+        }
+        return *LocalPool;
+    }
+
+    RecvBuffer RecvBufferPool::borrow()
+    {
+        if (_free == nullptr) {
+            // take back everything that was released on other threads
+            _free = _remoteFree.exchange(nullptr, std::memory_order_acquire);
+            if (_free == nullptr) {
+                refill();
+            }
+        }
+
+        auto block = _free;
+        _free = block->next;
+        block->next = nullptr;
+        _borrowed.fetch_add(1, std::memory_order_relaxed);
+        return RecvBuffer{block};
+    }
+
+    void RecvBufferPool::giveBack(detail::recv_block *block) noexcept
+    {
+        _borrowed.fetch_sub(1, std::memory_order_relaxed);
+        if (this == LocalPool) {
+            block->next = _free;
+            _free = block;
+            return;
+        }
+
+        auto head = _remoteFree.load(std::memory_order_relaxed);
+        do {
+            block->next = head;
+        } while (!_remoteFree.compare_exchange_weak(head,
+                                                    block,
+                                                    std::memory_order_release,
+                                                    std::memory_order_relaxed));
+    }
+
+    void RecvBufferPool::refill()
+    {
+        auto slab = static_cast<detail::recv_block *>(
+                operator new(sizeof(detail::recv_block) * SUIL_ASYNC_RECV_BUFFER_SLAB));
+        for (auto i = 0u; i < SUIL_ASYNC_RECV_BUFFER_SLAB; i++) {
+            auto block = new (slab + i) detail::recv_block;
+            block->owner = this;
+            block->next = _free;
+            _free = block;
+        }
+        _slabs.push_back(slab);
+        _slabCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    RecvBufferPool::Stats RecvBufferPool::getStats() const
+    {
+        return {
+            _slabCount.load(std::memory_order_relaxed),
+            _borrowed.load(std::memory_order_relaxed)
+        };
+    }
+}
@@ -0,0 +1,415 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-23
+ */
+
+#include "suil/async/detail/resolver.hpp"
+#include "suil/async/delay.hpp"
+#include "suil/async/fdwait.hpp"
+#include "suil/async/scheduler.hpp"
+
+#include <poll.h>
+
+#include "dns/dns.h"
+
+#include <cstring>
+#include <mutex>
+
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/random.h>
+#include <sys/socket.h>
+
+namespace suil::detail {
+
+    static struct dns_resolv_conf *suil_dns_conf{nullptr};
+    static struct dns_hosts *suil_dns_hosts{nullptr};
+    static struct dns_hints *suil_dns_hints{nullptr};
+    static std::once_flag suil_dns_once{};
+
+    static void dnsRandomBytes(void *buf, std::size_t len)
+    {
+        auto nRead = ::getrandom(buf, len, 0);
+        while (nRead < 0 && errno == EINTR) {
+            nRead = ::getrandom(buf, len, 0);
+        }
+        SUIL_ASSERT(nRead == ssize_t(len));
+    }
+
+    static unsigned dnsRandom()
+    {
+        unsigned value;
+        dnsRandomBytes(&value, sizeof(value));
+        return value;
+    }
+
+    static void dnsInit()
+    {
+        /* Load DNS config files once, they are shared by all resolvers */
+        std::call_once(suil_dns_once, [] {
+            int rc;
+            // dns.c defaults to the unseeded random() on Linux, its query IDs
+            // and ports would be the same on every run
+            dns_random = dnsRandom;
+            suil_dns_conf = dns_resconf_local(&rc);
+            SUIL_ASSERT(suil_dns_conf);
+            suil_dns_hosts = dns_hosts_local(&rc);
+            SUIL_ASSERT(suil_dns_hosts);
+            suil_dns_hints = dns_hints_local(suil_dns_conf, &rc);
+            SUIL_ASSERT(suil_dns_hints);
+        });
+    }
+
+    static socklen_t dnsAddrLen(const struct sockaddr_storage& ss)
+    {
+        return ss.ss_family == AF_INET6? sizeof(struct sockaddr_in6) : sizeof(struct sockaddr_in);
+    }
+
+    static bool isNameServer(const struct sockaddr_storage& from)
+    {
+        for (auto& ns: suil_dns_conf->nameserver) {
+            if (ns.ss_family == from.ss_family && memcmp(&ns, &from, dnsAddrLen(ns)) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    stub_resolver::stub_resolver(uint16 tid)
+        : _tid{tid}
+    {}
+
+    stub_resolver& stub_resolver::local()
+    {
+        // never released, async threads live for the lifetime of the process
+        static __thread stub_resolver *Resolver{nullptr};
+        if (Resolver == nullptr) {
+            Resolver = new stub_resolver(uint16(qid()));
+        }
+        return *Resolver;
+    }
+
+    auto stub_resolver::query(std::string name, int type, int64 deadline) -> Task<resolver_reply>
+    {
+        dnsInit();
+        if (qid() < 0) {
+            // the resolver's sockets are driven by an async thread
+            co_await schedule();
+        }
+
+        co_return co_await local().lookup(std::move(name), type, deadline);
+    }
+
+    auto stub_resolver::lookup(std::string name, int type, int64 deadline) -> LazyTask<resolver_reply>
+    {
+        resolver_reply reply{};
+        dns_resconf_i_t state{0};
+        char qname[DNS_D_MAXNAME + 1];
+        std::string last{};
+        std::size_t len;
+        while ((len = dns_resconf_search(qname, sizeof(qname), name.data(), name.size(), suil_dns_conf, &state)) != 0) {
+            // the default search domain is the root, which only appends a redundant dot
+            while (len > 1 && qname[len - 1] == '.' && qname[len - 2] == '.') {
+                qname[--len] = '\0';
+            }
+            if (last == qname) {
+                continue;
+            }
+            last = qname;
+
+            if (reply.packet != nullptr) {
+                free(reply.packet);
+            }
+
+            reply = co_await exchange(last, type, deadline);
+            if (reply.packet == nullptr) {
+                break;
+            }
+
+            auto rcode = dns_p_rcode(reply.packet);
+            if (dns_p_count(reply.packet, DNS_S_AN) != 0 || (rcode != DNS_RC_NOERROR && rcode != DNS_RC_NXDOMAIN)) {
+                break;
+            }
+            // the name does not exist in this domain, try the next one on the search list
+        }
+
+        if (reply.packet == nullptr && reply.error == 0) {
+            reply.error = DNS_ENONAME;
+        }
+        co_return reply;
+    }
+
+    auto stub_resolver::exchange(const std::string& qname, int type, int64 deadline) -> LazyTask<resolver_reply>
+    {
+        resolver_reply reply{};
+        int error{0};
+        auto Q = dns_p_make(DNS_P_QBUFSIZ, &error);
+        if (Q == nullptr) {
+            reply.error = error;
+            co_return reply;
+        }
+
+        error = dns_p_push(Q, DNS_S_QD, qname.data(), qname.size(), dns_type(type), DNS_C_IN, 0, nullptr);
+        if (error != 0) {
+            free(Q);
+            reply.error = error;
+            co_return reply;
+        }
+        dns_header(Q)->rd = 1;
+
+        auto hosts = dns_hosts_query(suil_dns_hosts, Q, &error);
+        if (hosts != nullptr && dns_p_count(hosts, DNS_S_AN) != 0) {
+            free(Q);
+            reply.packet = hosts;
+            co_return reply;
+        }
+        free(hosts);
+
+        constexpr auto MaxServers = std::size(decltype(dns_resolv_conf::nameserver){});
+        int servers[MaxServers], nServers{0};
+        for (auto i = 0u; i < MaxServers; i++) {
+            auto family = suil_dns_conf->nameserver[i].ss_family;
+            if (family == AF_INET || family == AF_INET6) {
+                servers[nServers++] = int(i);
+            }
+        }
+
+        auto id = nextId();
+        dns_header(Q)->qid = id;
+        pending query{nullptr, Q, nullptr};
+        _pending.emplace(id, &query);
+
+        error = nServers == 0? ECONNREFUSED : ETIMEDOUT;
+        auto attempts = std::max(suil_dns_conf->options.attempts, 1u) * nServers;
+        auto first = (suil_dns_conf->options.rotate && nServers != 0)? id % nServers : 0;
+        bool truncated{false};
+        for (auto i = 0u; i < attempts; i++) {
+            auto& ns = suil_dns_conf->nameserver[servers[(first + i) % nServers]];
+            auto chan = open(ns.ss_family);
+            if (chan == nullptr) {
+                error = errno;
+                continue;
+            }
+            if (::sendto(chan->fd, Q->data, Q->end, 0, (const struct sockaddr *) &ns, dnsAddrLen(ns)) < 0) {
+                error = errno;
+                release(chan);
+                continue;
+            }
+
+            // wait for the answer until the retransmission timeout, the reader cancels the wait
+            auto dd = fastnow() + std::max<int64>(suil_dns_conf->options.timeout, 1) * 1000;
+            if (deadline >= 0 && deadline < dd) {
+                dd = deadline;
+            }
+            Delay timer{std::max<int64>(dd - fastnow(), 0), _tid};
+            query.waiter = &timer;
+            co_await timer;
+            query.waiter = nullptr;
+            release(chan);
+
+            if (query.answer != nullptr) {
+                auto rcode = dns_p_rcode(query.answer);
+                if (dns_header(query.answer)->tc) {
+                    truncated = true;
+                }
+                else if ((rcode == DNS_RC_SERVFAIL || rcode == DNS_RC_NOTIMP || rcode == DNS_RC_REFUSED) &&
+                         i + 1 < attempts)
+                {
+                    // give the next server a chance
+                    free(query.answer);
+                    query.answer = nullptr;
+                    error = ECONNREFUSED;
+                    continue;
+                }
+                break;
+            }
+
+            error = ETIMEDOUT;
+            if (deadline >= 0 && fastnow() >= deadline) {
+                break;
+            }
+        }
+
+        _pending.erase(id);
+        free(Q);
+
+        if (truncated) {
+            // the answer does not fit in a datagram, let the full resolver retry over TCP
+            free(query.answer);
+            co_return co_await fallback(qname, type, deadline);
+        }
+
+        reply.packet = query.answer;
+        reply.error = query.answer == nullptr? error : 0;
+        co_return reply;
+    }
+
+    auto stub_resolver::fallback(std::string name, int type, int64 deadline) -> LazyTask<resolver_reply>
+    {
+        resolver_reply reply{};
+        int rc;
+        auto opts = dns_opts();
+        struct dns_resolver *resolver = dns_res_open(suil_dns_conf, suil_dns_hosts,
+                                                     suil_dns_hints, nullptr, &opts, &rc);
+        if (resolver == nullptr) {
+            reply.error = rc;
+            co_return reply;
+        }
+
+        rc = dns_res_submit(resolver, name.c_str(), dns_type(type), DNS_C_IN);
+        while (rc == 0 && (rc = dns_res_check(resolver)) == EAGAIN) {
+            // never wait past the resolver's retransmission timeout
+            auto dd = fastnow() + std::max<int64>(dns_res_timeout(resolver), 1) * 1000;
+            if (deadline >= 0 && deadline < dd) {
+                dd = deadline;
+            }
+
+            auto io = (dns_res_events(resolver) & DNS_POLLOUT)? Event::OUT : Event::IN;
+            auto ev = co_await fdwait(dns_res_pollfd(resolver), io, dd);
+            if (ev == Event::esTIMEOUT) {
+                if (deadline >= 0 && fastnow() >= deadline) {
+                    rc = ETIMEDOUT;
+                    break;
+                }
+            }
+            else if (ev != Event::esFIRED) {
+                rc = errno;
+                break;
+            }
+            rc = 0;
+        }
+
+        if (rc == 0) {
+            reply.packet = dns_res_fetch(resolver, &rc);
+        }
+
+        dns_res_close(resolver);
+        reply.error = reply.packet == nullptr? rc : 0;
+        co_return reply;
+    }
+
+    auto stub_resolver::open(int family) -> channel *
+    {
+        auto& current = _channels[family == AF_INET6? 1 : 0];
+        if (current != nullptr && current->sent >= SUIL_ASYNC_DNS_PORT_QUERIES) {
+            // move on to a new source port, an attacker must guess both the port and the query ID
+            current->retired = true;
+            if (current->waiting == 0) {
+                current->stop.cancel();
+            }
+            current = nullptr;
+        }
+
+        if (current == nullptr) {
+            // the kernel binds the socket to a random ephemeral port on the first send
+            int fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd == INVALID_FD) {
+                return nullptr;
+            }
+            current = new channel{.fd = fd};
+            reader(current);
+        }
+
+        current->sent++;
+        current->waiting++;
+        return current;
+    }
+
+    void stub_resolver::release(channel *chan)
+    {
+        SUIL_ASSERT(chan->waiting > 0);
+        if (--chan->waiting == 0 && chan->retired) {
+            // the reader closes the socket
+            chan->stop.cancel();
+        }
+    }
+
+    uint16 stub_resolver::nextId()
+    {
+        // answers are matched by query ID, the IDs must be unpredictable
+        uint16 id;
+        do {
+            if (_nIds == 0) {
+                dnsRandomBytes(_ids, sizeof(_ids));
+                _nIds = std::size(_ids);
+            }
+            id = _ids[--_nIds];
+        } while (_pending.contains(id));
+        return id;
+    }
+
+    VoidTask<> stub_resolver::reader(channel *chan)
+    {
+        char buf[SUIL_ASYNC_DNS_MAX_PACKET];
+        while (true) {
+            struct sockaddr_storage from{};
+            socklen_t len = sizeof(from);
+            auto nRead = ::recvfrom(chan->fd, buf, sizeof(buf), 0, (struct sockaddr *) &from, &len);
+            if (nRead >= 0) {
+                if (isNameServer(from)) {
+                    dispatch(buf, std::size_t(nRead));
+                }
+                continue;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            }
+
+            // errors are not fatal, pending queries time out and retransmit
+            auto ev = co_await fdwait(chan->fd, Event::IN, -1, chan->stop.token(), _tid);
+            if (ev == Event::esCANCELLED) {
+                // the socket was retired
+                break;
+            }
+        }
+
+        ::close(chan->fd);
+        delete chan;
+    }
+
+    void stub_resolver::dispatch(const char *buf, std::size_t len)
+    {
+        if (len < 12) {
+            return;
+        }
+
+        uint16 id;
+        memcpy(&id, buf, sizeof(id));
+        auto it = _pending.find(id);
+        if (it == _pending.end() || it->second->answer != nullptr) {
+            // late or duplicate answer
+            return;
+        }
+
+        // the answer must echo the question
+        auto query = it->second;
+        auto Q = query->question;
+        if (len < Q->end || memcmp(buf + 4, Q->data + 4, 2) != 0 || memcmp(buf + 12, Q->data + 12, Q->end - 12) != 0) {
+            return;
+        }
+
+        int error;
+        auto P = dns_p_make(len, &error);
+        if (P == nullptr) {
+            return;
+        }
+        memcpy(P->data, buf, len);
+        P->end = len;
+        if (dns_p_study(P) != 0) {
+            free(P);
+            return;
+        }
+
+        query->answer = P;
+        if (query->waiter != nullptr) {
+            // resumes the query inline, it may not be accessed afterwards
+            Scheduler::instance().unschedule(query->waiter);
+        }
+    }
+}
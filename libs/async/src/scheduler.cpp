@@ -95,6 +95,40 @@ namespace suil {
         _totalScheduled++;
     }
 
+    void Scheduler::schedule(Alarm *alarm, uint16 tid)
+    {
+        if (tid == THREAD_ID_ANY) {
+            tid = minLoadSchedule();
+        }
+        SUIL_ASSERT(tid < _threadCount);
+        _threads[tid].add(alarm);
+    }
+
+    void Scheduler::unschedule(Delay *timer)
+    {
+        SUIL_ASSERT(timer->_owner < _threadCount);
+        _threads[timer->_owner].remove(timer);
+    }
+
+    void Scheduler::cancel(Event *event)
+    {
+        auto owner = event->handle().owner;
+        SUIL_ASSERT(owner < _threadCount);
+        _threads[owner].cancel(event);
+    }
+
+    void Scheduler::cancel(Delay *timer)
+    {
+        SUIL_ASSERT(timer->_owner < _threadCount);
+        _threads[timer->_owner].cancel(timer);
+    }
+
+    bool Scheduler::cancel(Alarm *alarm)
+    {
+        SUIL_ASSERT(alarm->_owner < _threadCount);
+        return _threads[alarm->_owner].cancel(alarm);
+    }
+
     uint16 Scheduler::minLoadSchedule()
     {
         uint64 minLoad = UINT64_MAX;
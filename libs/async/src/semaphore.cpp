@@ -0,0 +1,130 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#include "suil/async/semaphore.hpp"
+
+namespace suil {
+
+    AsyncSemaphore::AsyncSemaphore(uint64 permits) noexcept
+        : _state{permits}
+    {
+        SUIL_ASSERT(permits < HAS_WAITERS);
+    }
+
+    AsyncSemaphore::~AsyncSemaphore()
+    {
+        SUIL_ASSERT(_waiters.empty());
+    }
+
+    bool AsyncSemaphore::tryAcquire(uint64 n) noexcept
+    {
+        auto state = _state.load(std::memory_order_relaxed);
+        while (!(state & HAS_WAITERS) && state >= n) {
+            if (_state.compare_exchange_weak(state, state - n, std::memory_order_acquire, std::memory_order_relaxed)) {
+                _acquired.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    AsyncSemaphore::acquire_operation AsyncSemaphore::acquire(uint64 n, milliseconds timeout) noexcept
+    {
+        return acquire_operation{*this, n, afterd(timeout)};
+    }
+
+    void AsyncSemaphore::release(uint64 n)
+    {
+        auto state = _state.load(std::memory_order_relaxed);
+        while (!(state & HAS_WAITERS)) {
+            if (_state.compare_exchange_weak(state, state + n, std::memory_order_release, std::memory_order_relaxed)) {
+                return;
+            }
+        }
+
+        // the state word only changes with the lock held while coroutines are waiting
+        std::lock_guard<std::mutex> lk{_lock};
+        _state.fetch_add(n, std::memory_order_relaxed);
+        dispatch();
+    }
+
+    void AsyncSemaphore::dispatch()
+    {
+        // must be called with the lock held
+        auto permits = _state.load(std::memory_order_relaxed) & ~HAS_WAITERS;
+        while (!_waiters.empty() && _waiters.head->count <= permits) {
+            permits -= _waiters.head->count;
+            _acquired.fetch_add(1, std::memory_order_relaxed);
+            _waiters.grant();
+        }
+        _state.store(_waiters.empty()? permits : (permits | HAS_WAITERS), std::memory_order_release);
+    }
+
+    uint64 AsyncSemaphore::available() const noexcept
+    {
+        return _state.load(std::memory_order_relaxed) & ~HAS_WAITERS;
+    }
+
+    std::size_t AsyncSemaphore::waiting() const
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        return _waiters.size;
+    }
+
+    WaitStats AsyncSemaphore::getStats() const
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        auto stats = _waiters.stats;
+        stats.acquired = _acquired.load(std::memory_order_relaxed);
+        return stats;
+    }
+
+    bool AsyncSemaphore::acquire_operation::await_suspend(std::coroutine_handle<> coroutine)
+    {
+        std::lock_guard<std::mutex> lk{_semaphore._lock};
+        auto state = _semaphore._state.load(std::memory_order_relaxed);
+        while (!(state & HAS_WAITERS)) {
+            if (state >= _waiter.count) {
+                if (_semaphore._state.compare_exchange_weak(state, state - _waiter.count,
+                                                            std::memory_order_acquire, std::memory_order_relaxed))
+                {
+                    _semaphore._acquired.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+            }
+            else if (_semaphore._state.compare_exchange_weak(state, state | HAS_WAITERS,
+                                                               std::memory_order_relaxed, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+
+        // permits left while others wait are reserved for the head of the queue
+        _suspended = true;
+        _semaphore._waiters.park(_waiter, coroutine, _dd);
+        return true;
+    }
+
+    bool AsyncSemaphore::acquire_operation::await_resume()
+    {
+        if (!_suspended) {
+            return true;
+        }
+
+        std::lock_guard<std::mutex> lk{_semaphore._lock};
+        if (_semaphore._waiters.resumed(_waiter)) {
+            return true;
+        }
+
+        // a waiter that gave up might have been holding back those behind it
+        _semaphore.dispatch();
+        return false;
+    }
+}
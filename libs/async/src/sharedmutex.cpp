@@ -0,0 +1,196 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-26
+ */
+
+#include "suil/async/sharedmutex.hpp"
+#include "suil/async/scheduler.hpp"
+
+#ifndef SUIL_ASYNC_MAXIMUM_CONCURRENCY
+#define SUIL_ASYNC_MAXIMUM_CONCURRENCY 64u
+#endif
+
+namespace suil {
+
+    AsyncSharedMutexLock::~AsyncSharedMutexLock()
+    {
+        if (_mutex) {
+            if (_shared) {
+                _mutex->unlockShared();
+            }
+            else {
+                _mutex->unlock();
+            }
+            _mutex = nullptr;
+        }
+    }
+
+    AsyncSharedMutex::AsyncSharedMutex()
+        // one counter per async thread plus one shared by other threads. Mutexes created
+        // before the scheduler is started (e.g. globals) are sized for as many threads
+        // as the scheduler can run.
+        : _nSlots{uint16((Scheduler::instance().threadCount() == 0?
+                          SUIL_ASYNC_MAXIMUM_CONCURRENCY : Scheduler::instance().threadCount()) + 1)}
+    {
+        _slots = std::make_unique<reader_slot[]>(_nSlots);
+    }
+
+    AsyncSharedMutex::~AsyncSharedMutex()
+    {
+        SUIL_ASSERT(_state.load(std::memory_order_relaxed) == 0);
+        SUIL_ASSERT(readers() == 0);
+    }
+
+    AsyncSharedMutex::reader_slot& AsyncSharedMutex::slot() noexcept
+    {
+        auto id = qid();
+        return _slots[(id >= 0 && id < _nSlots - 1)? id : _nSlots - 1];
+    }
+
+    int64 AsyncSharedMutex::readers() const noexcept
+    {
+        int64 count{0};
+        for (auto i = 0u; i < _nSlots; i++) {
+            count += _slots[i].count.load(std::memory_order_seq_cst);
+        }
+        return count;
+    }
+
+    bool AsyncSharedMutex::tryLockShared() noexcept
+    {
+        auto& s = slot();
+        // pairs with the writer setting WRITER before counting the readers, either
+        // the writer sees this reader or this reader sees the writer
+        s.count.fetch_add(1, std::memory_order_seq_cst);
+        if (!(_state.load(std::memory_order_seq_cst) & WRITER)) {
+            return true;
+        }
+
+        s.count.fetch_sub(1, std::memory_order_seq_cst);
+        readerLeft();
+        return false;
+    }
+
+    AsyncSharedMutex::lock_shared_operation AsyncSharedMutex::lockSharedAsync() noexcept
+    {
+        return AsyncSharedMutex::lock_shared_operation{*this};
+    }
+
+    AsyncSharedMutex::scoped_lock_shared_operation AsyncSharedMutex::scopedLockSharedAsync() noexcept
+    {
+        return AsyncSharedMutex::scoped_lock_shared_operation{*this};
+    }
+
+    bool AsyncSharedMutex::lockSharedSlow(detail::timed_waiter& w, std::coroutine_handle<> coro)
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        if (!(_state.load(std::memory_order_relaxed) & WRITER)) {
+            // the writer left, WRITER cannot be set while the lock is held
+            slot().count.fetch_add(1, std::memory_order_seq_cst);
+            return false;
+        }
+
+        _readers.park(w, coro, -1);
+        return true;
+    }
+
+    void AsyncSharedMutex::unlockShared()
+    {
+        slot().count.fetch_sub(1, std::memory_order_seq_cst);
+        if (_state.load(std::memory_order_seq_cst) & WRITER) {
+            readerLeft();
+        }
+    }
+
+    void AsyncSharedMutex::readerLeft()
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        if (_draining && readers() == 0) {
+            // the last reader left, hand over to the writer waiting for it
+            _draining = false;
+            _writers.grant();
+        }
+    }
+
+    bool AsyncSharedMutex::tryLock()
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        if (_state.load(std::memory_order_relaxed) & WRITER) {
+            return false;
+        }
+
+        _state.store(WRITER, std::memory_order_seq_cst);
+        if (readers() != 0) {
+            // readers that backed off meanwhile retry with the lock held and find WRITER cleared
+            _state.store(0, std::memory_order_seq_cst);
+            return false;
+        }
+        return true;
+    }
+
+    AsyncSharedMutex::lock_operation AsyncSharedMutex::lockAsync() noexcept
+    {
+        return AsyncSharedMutex::lock_operation{*this};
+    }
+
+    AsyncSharedMutex::scoped_lock_operation AsyncSharedMutex::scopedLockAsync() noexcept
+    {
+        return AsyncSharedMutex::scoped_lock_operation{*this};
+    }
+
+    bool AsyncSharedMutex::lockSlow(detail::timed_waiter& w, std::coroutine_handle<> coro)
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        if (_state.load(std::memory_order_relaxed) & WRITER) {
+            // queue up behind the writer holding the lock
+            _writers.park(w, coro, -1);
+            return true;
+        }
+
+        _state.store(WRITER, std::memory_order_seq_cst);
+        if (readers() == 0) {
+            return false;
+        }
+
+        // wait for the readers to leave, new readers queue up
+        _draining = true;
+        _writers.park(w, coro, -1);
+        return true;
+    }
+
+    void AsyncSharedMutex::unlock()
+    {
+        std::lock_guard<std::mutex> lk{_lock};
+        SUIL_ASSERT((_state.load(std::memory_order_relaxed) & WRITER) && !_draining);
+        if (!_readers.empty()) {
+            // the readers that queued up while the lock was held go first, they are
+            // counted on the shared counter and uncount themselves wherever they unlock
+            while (!_readers.empty()) {
+                _slots[_nSlots - 1].count.fetch_add(1, std::memory_order_seq_cst);
+                _readers.grant();
+            }
+
+            if (_writers.empty()) {
+                _state.store(0, std::memory_order_seq_cst);
+            }
+            else {
+                // the next writer waits for them to leave
+                _draining = true;
+            }
+            return;
+        }
+
+        if (!_writers.empty()) {
+            // hand over to the next writer, WRITER stays set
+            _writers.grant();
+            return;
+        }
+
+        _state.store(0, std::memory_order_seq_cst);
+    }
+}
@@ -16,10 +16,23 @@
 
 namespace suil {
 
+    int16 Socket::waitError(Event::State ev)
+    {
+        switch (ev) {
+            case Event::esTIMEOUT:
+                return ETIMEDOUT;
+            case Event::esCANCELLED:
+                return ECANCELED;
+            default:
+                return int16(errno);
+        }
+    }
+
     Socket::Socket(Socket&& other) noexcept
         : _fd{std::exchange(other._fd, INVALID_FD)},
           _error{std::exchange(other._error, 0)},
-          _tID{std::exchange(other._tID, THREAD_ID_ANY)}
+          _tID{std::exchange(other._tID, THREAD_ID_ANY)},
+          _slack{std::exchange(other._slack, milliseconds{0})}
     {}
 
     Socket& Socket::operator=(Socket&& other) noexcept
@@ -28,6 +41,7 @@ namespace suil {
             _fd = std::exchange(other._fd, INVALID_FD);
             _error = std::exchange(other._error, 0);
             _tID = std::exchange(other._tID, THREAD_ID_ANY);
+            _slack = std::exchange(other._slack, milliseconds{0});
         }
         return *this;
     }
@@ -51,7 +65,7 @@ namespace suil {
         return std::exchange(_fd, INVALID_FD);
     }
 
-    auto Socket::send(const void* buf, std::size_t size, milliseconds timeout) -> Task<int>
+    auto Socket::send(const void* buf, std::size_t size, milliseconds timeout, CancellationToken token) -> Task<int>
     {
         auto deadline = afterd(timeout);
         ssize_t nSent{0};
@@ -67,9 +81,9 @@ namespace suil {
                     break;
                 }
 
-                auto ev = co_await fdwait(_fd, Event::OUT, deadline, _tID);
+                auto ev = co_await fdwait(_fd, Event::OUT, deadline, _slack, token, _tID);
                 if (ev != Event::esFIRED) {
-                    _error = int16(ev ==  Event::esTIMEOUT? ETIMEDOUT : errno);
+                    _error = waitError(ev);
                     break;
                 }
 
@@ -81,7 +95,7 @@ namespace suil {
         co_return int(nSent);
     }
 
-    auto Socket::sendAll(const void* buf, std::size_t size, milliseconds timeout) -> Task<int>
+    auto Socket::sendAll(const void* buf, std::size_t size, milliseconds timeout, CancellationToken token) -> Task<int>
     {
         auto deadline = afterd(timeout);
         ssize_t nSent{0}, rc{0};
@@ -98,9 +112,9 @@ namespace suil {
                     break;
                 }
 
-                auto ev = co_await fdwait(_fd, Event::OUT, deadline, _tID);
+                auto ev = co_await fdwait(_fd, Event::OUT, deadline, _slack, token, _tID);
                 if (ev != Event::esFIRED) {
-                    _error = int16(ev ==  Event::esTIMEOUT? ETIMEDOUT : errno);
+                    _error = waitError(ev);
                     nSent = -1;
                     break;
                 }
@@ -118,7 +132,7 @@ namespace suil {
         co_return int(nSent);
     }
 
-    auto Socket::receive(void* buf, std::size_t size, milliseconds timeout) -> Task<int>
+    auto Socket::receive(void* buf, std::size_t size, milliseconds timeout, CancellationToken token) -> Task<int>
     {
         auto deadline = afterd(timeout);
         ssize_t nReceived{0};
@@ -134,9 +148,9 @@ namespace suil {
                     break;
                 }
 
-                auto ev = co_await fdwait(_fd, Event::IN, deadline, _tID);
+                auto ev = co_await fdwait(_fd, Event::IN, deadline, _slack, token, _tID);
                 if (ev != Event::esFIRED) {
-                    _error = int16(ev ==  Event::esTIMEOUT? ETIMEDOUT : errno);
+                    _error = waitError(ev);
                     break;
                 }
 
@@ -151,7 +165,7 @@ namespace suil {
         co_return int(nReceived);
     }
 
-    auto Socket::receiveAll(void* buf, std::size_t size, milliseconds timeout) -> Task<int>
+    auto Socket::receiveAll(void* buf, std::size_t size, milliseconds timeout, CancellationToken token) -> Task<int>
     {
         auto deadline = afterd(timeout);
         ssize_t nReceived{0}, rc{0};
@@ -168,9 +182,9 @@ namespace suil {
                     break;
                 }
 
-                auto ev = co_await fdwait(_fd, Event::IN, deadline, _tID);
+                auto ev = co_await fdwait(_fd, Event::IN, deadline, _slack, token, _tID);
                 if (ev != Event::esFIRED) {
-                    _error = int16(ev ==  Event::esTIMEOUT? ETIMEDOUT : errno);
+                    _error = waitError(ev);
                     nReceived = -1;
                     break;
                 }
@@ -188,6 +202,42 @@ namespace suil {
         co_return int(nReceived);
     }
 
+    auto Socket::receiveBuffered(milliseconds timeout, CancellationToken token) -> Task<RecvBuffer>
+    {
+        auto deadline = afterd(timeout);
+        do {
+            auto buf = RecvBufferPool::local().borrow();
+            auto nReceived = ::recv(_fd, buf.data(), buf.capacity(), MSG_NOSIGNAL);
+            if (nReceived > 0) {
+                buf._size = std::size_t(nReceived);
+                co_return std::move(buf);
+            }
+
+            // hand the buffer back before waiting, idle sockets must not pin buffers
+            buf.release();
+            if (nReceived == 0) {
+                _error = errno = ECONNRESET;
+                break;
+            }
+            if (errno == EPIPE) {
+                _error = errno = ECONNRESET;
+                break;
+            }
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _error = errno;
+                break;
+            }
+
+            auto ev = co_await fdwait(_fd, Event::IN, deadline, _slack, token, _tID);
+            if (ev != Event::esFIRED) {
+                _error = waitError(ev);
+                break;
+            }
+        } while (true);
+
+        co_return RecvBuffer{};
+    }
+
     void Socket::bindToThread(uint16 tID)
     {
         SUIL_ASSERT(tID == THREAD_ID_ANY or tID < Scheduler::instance().threadCount());
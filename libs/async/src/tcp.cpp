@@ -13,6 +13,7 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 
 namespace {
@@ -42,6 +43,31 @@ namespace {
 #endif
     }
 
+    std::vector<suil::SocketAddress> interleave(std::vector<suil::SocketAddress>&& addrs)
+    {
+        // RFC 8305 section 4, alternate address families starting with the preferred one
+        if (addrs.size() < 2) {
+            return std::move(addrs);
+        }
+
+        std::vector<suil::SocketAddress> preferred, others, ordered;
+        auto family = addrs.front().family();
+        for (auto& addr: addrs) {
+            (addr.family() == family? preferred : others).push_back(addr);
+        }
+
+        ordered.reserve(addrs.size());
+        for (auto i = 0u; i < preferred.size() || i < others.size(); i++) {
+            if (i < preferred.size()) {
+                ordered.push_back(preferred[i]);
+            }
+            if (i < others.size()) {
+                ordered.push_back(others[i]);
+            }
+        }
+        return ordered;
+    }
+
 }
 
 namespace suil {
@@ -70,7 +96,7 @@ namespace suil {
     {
         int s = socket(addr.family(), SOCK_STREAM, 0);
         if (s == -1) {
-            co_return TcpSocket{s, errno };
+            co_return TcpSocket{INVALID_FD, errno, queueID};
         }
 
         tcptune(s);
@@ -80,12 +106,18 @@ namespace suil {
         if (rc != 0) {
             SUIL_ASSERT(rc == -1);
             if(errno != EINPROGRESS) {
-                co_return TcpSocket{s, errno, queueID};
+                int err = errno;
+                ::close(s);
+                errno = err;
+                co_return TcpSocket{INVALID_FD, err, queueID};
             }
 
             auto ev = co_await fdwait(s, Event::OUT, afterd(timeout), queueID);
             if (ev != Event::esFIRED) {
-                co_return TcpSocket{s, errno, queueID};
+                int err = ev == Event::esTIMEOUT? ETIMEDOUT : errno;
+                ::close(s);
+                errno = err;
+                co_return TcpSocket{INVALID_FD, err, queueID};
             }
 
             int err;
@@ -95,18 +127,20 @@ namespace suil {
                 err = errno;
                 ::close(s);
                 errno = err;
-                co_return TcpSocket{s, errno, queueID};
+                co_return TcpSocket{INVALID_FD, errno, queueID};
             }
 
             if(err != 0) {
                 ::close(s);
                 errno = err;
-                co_return TcpSocket{s, errno, queueID};
+                co_return TcpSocket{INVALID_FD, errno, queueID};
             }
         }
 
         errno = 0;
-        co_return TcpSocket{s, 0, queueID};
+        TcpSocket sock{s, 0, queueID};
+        sock._address = addr;
+        co_return sock;
     }
 
     Task<TcpSocket> TcpSocket::connect(const SocketAddress& addr, milliseconds timeout)
@@ -114,6 +148,133 @@ namespace suil {
         return connect(addr, THREAD_ID_ANY, timeout);
     }
 
+    Task<TcpSocket> TcpSocket::connectAny(std::vector<SocketAddress> addrs, milliseconds stagger, milliseconds timeout, uint16 queueID)
+    {
+        addrs = interleave(std::move(addrs));
+        if (addrs.empty()) {
+            errno = EADDRNOTAVAIL;
+            co_return TcpSocket{INVALID_FD, errno, queueID};
+        }
+
+        if (addrs.size() == 1) {
+            co_return co_await connect(addrs.front(), queueID, timeout);
+        }
+
+        // attempts in progress are watched through a private epoll set, which
+        // is itself waited on like any other file descriptor
+        int epfd = epoll_create1(EPOLL_CLOEXEC);
+        if (epfd == -1) {
+            co_return TcpSocket{INVALID_FD, errno, queueID};
+        }
+
+        std::vector<int> attempts(addrs.size(), INVALID_FD);
+        auto deadline = afterd(timeout);
+        int64 nextAttempt{0};
+        std::size_t next{0}, pending{0};
+        int winner{-1}, lastError{ECONNREFUSED};
+
+        while (winner < 0) {
+            if (next < addrs.size() && (pending == 0 || fastnow() >= nextAttempt)) {
+                auto i = next++;
+                int s = socket(addrs[i].family(), SOCK_STREAM, 0);
+                if (s == -1) {
+                    lastError = errno;
+                    continue;
+                }
+
+                tcptune(s);
+                attempts[i] = s;
+                int rc = ::connect(s, (struct sockaddr*) addrs[i]._data, addrs[i].size());
+                if (rc == 0) {
+                    winner = int(i);
+                    break;
+                }
+
+                if (errno != EINPROGRESS) {
+                    lastError = errno;
+                    ::close(s);
+                    attempts[i] = INVALID_FD;
+                    continue;
+                }
+
+                struct epoll_event ev{};
+                ev.events = EPOLLOUT;
+                ev.data.u32 = uint32(i);
+                epoll_ctl(epfd, EPOLL_CTL_ADD, s, &ev);
+                pending++;
+                nextAttempt = fastnow() + stagger.count();
+                continue;
+            }
+
+            if (pending == 0) {
+                // every address failed
+                break;
+            }
+
+            auto dd = deadline;
+            if (next < addrs.size() && (dd < 0 || nextAttempt < dd)) {
+                dd = nextAttempt;
+            }
+
+            auto ev = co_await fdwait(epfd, Event::IN, dd, queueID);
+            if (ev == Event::esTIMEOUT) {
+                if (deadline >= 0 && fastnow() >= deadline) {
+                    lastError = ETIMEDOUT;
+                    break;
+                }
+                // time to start the next attempt
+                continue;
+            }
+
+            if (ev != Event::esFIRED) {
+                lastError = errno;
+                break;
+            }
+
+            struct epoll_event events[16];
+            int nReady = epoll_wait(epfd, events, 16, 0);
+            for (int j = 0; j < nReady && winner < 0; j++) {
+                auto i = events[j].data.u32;
+                int err{0};
+                socklen_t errsz = sizeof(err);
+                if (getsockopt(attempts[i], SOL_SOCKET, SO_ERROR, (void*)&err, &errsz) != 0) {
+                    err = errno;
+                }
+
+                epoll_ctl(epfd, EPOLL_CTL_DEL, attempts[i], nullptr);
+                pending--;
+                if (err == 0) {
+                    winner = int(i);
+                    break;
+                }
+
+                lastError = err;
+                ::close(attempts[i]);
+                attempts[i] = INVALID_FD;
+                // a failed attempt starts the next one right away
+                nextAttempt = 0;
+            }
+        }
+
+        ::close(epfd);
+        for (auto i = 0u; i < attempts.size(); i++) {
+            // cancel the attempts that lost the race
+            if (int(i) != winner && attempts[i] != INVALID_FD) {
+                ::close(attempts[i]);
+            }
+        }
+
+        if (winner < 0) {
+            errno = lastError;
+            co_return TcpSocket{INVALID_FD, lastError, queueID};
+        }
+
+        errno = 0;
+        TcpSocket sock{attempts[winner], 0, queueID};
+        sock._address = addrs[winner];
+        co_return sock;
+    }
+
     void TcpSocket::close() noexcept
     {
         if (isValid()) {
@@ -12,11 +12,24 @@
 
 #include <sys/eventfd.h>
 #include <sys/epoll.h>
+#include <sys/timerfd.h>
 
 #ifndef SUIL_ASYNC_MAXIMUM_CONCURRENCY
 #define SUIL_ASYNC_MAXIMUM_CONCURRENCY 256u
 #endif
 
+#ifndef SUIL_ASYNC_SPARE_TIMER_BUCKETS
+// the number of emptied timer buckets each thread keeps for reuse
+#define SUIL_ASYNC_SPARE_TIMER_BUCKETS 64u
+#endif
+
+#ifdef __GLIBC_PREREQ
+#if __GLIBC_PREREQ(2, 35)
+// epoll_pwait2 takes a nanosecond timeout, available since Linux 5.11
+#define SUIL_ASYNC_HAVE_EPOLL_PWAIT2
+#endif
+#endif
+
 namespace suil {
 
     static __thread int16 QueueId = -1;
@@ -28,7 +41,7 @@ namespace suil {
     Thread::Thread(uint16 id)
         :_id{id}
     {
-        mill_list_init(&_timers);
+        _spareBuckets.reserve(SUIL_ASYNC_SPARE_TIMER_BUCKETS);
     }
 
     void Thread::start()
@@ -56,10 +69,7 @@ namespace suil {
             _active = true;
             while (_active) {
                 struct epoll_event events[SUIL_ASYNC_MAXIMUM_CONCURRENCY];
-                auto count = epoll_wait(_epfd,
-                                        events,
-                                        SUIL_ASYNC_MAXIMUM_CONCURRENCY,
-                                        computeWaitTimeout());
+                auto count = wait(events, SUIL_ASYNC_MAXIMUM_CONCURRENCY);
                 if (!_active) {
                     break;
                 }
@@ -68,15 +78,6 @@ namespace suil {
                     SUIL_ASSERT(errno == EINTR);
                 }
 
-                {
-                    std::coroutine_handle<> coro;
-                    while (_active && _scheduleQ.try_dequeue(coro)) {
-                        // resume all coroutines scheduled to this queue
-                        _stats.inflight--;
-                        coro.resume();
-                    }
-                }
-
                 int found{0};
                 for (int i = 0; _active && (i < count); i++) {
                     auto &triggered = events[i];
@@ -84,6 +85,10 @@ namespace suil {
                         handleThreadEvent();
                         continue;
                     }
+                    if (triggered.data.fd == _tmfd) {
+                        handleTimerEvent();
+                        continue;
+                    }
 
                     auto event = static_cast<Event *>(events[i].data.ptr);
                     auto &handle = event->handle();
@@ -101,6 +106,18 @@ namespace suil {
                     }
                 }
                 _stats.maxPolled = std::max(_stats.maxPolled, std::uint64_t(found));
+
+                {
+                    // resumed after the polled events were handled, a cancelled event may still be
+                    // among them and must outlive them
+                    std::coroutine_handle<> coro;
+                    while (_active && _scheduleQ.try_dequeue(coro)) {
+                        // resume all coroutines scheduled to this queue
+                        _stats.inflight--;
+                        coro.resume();
+                    }
+                }
+
                 if (_active) {
                     fireExpiredTimers();
                 }
@@ -110,6 +127,10 @@ namespace suil {
                 ::close(_evfd);
                 _evfd = INVALID_FD;
             }
+            if (_tmfd != INVALID_FD) {
+                ::close(_tmfd);
+                _tmfd = INVALID_FD;
+            }
             if (_epfd != INVALID_FD) {
                 ::close(_epfd);
                 _evfd = INVALID_FD;
@@ -139,6 +160,49 @@ namespace suil {
         SUIL_ASSERT(nrd == sizeof(count));
     }
 
+    void Thread::handleTimerEvent()
+    {
+        uint64 expirations{0};
+        // the timer is non-blocking and may have been re-armed before the read
+        auto nrd = read(_tmfd, &expirations, sizeof(expirations));
+        SUIL_ASSERT(nrd == sizeof(expirations) || errno == EAGAIN);
+    }
+
+    int Thread::wait(struct epoll_event *events, int maxEvents)
+    {
+        auto timeout = computeWaitTimeout();
+#ifdef SUIL_ASYNC_HAVE_EPOLL_PWAIT2
+        if (_pwait2) {
+            struct timespec ts{.tv_sec = timeout / 1000000000, .tv_nsec = timeout % 1000000000};
+            auto count = epoll_pwait2(_epfd, events, maxEvents, timeout < 0? nullptr : &ts, nullptr);
+            if (count != -1 || errno != ENOSYS) {
+                return count;
+            }
+            // kernel older than 5.11
+            _pwait2 = false;
+        }
+#endif
+        if (timeout <= 0 || timeout >= 1000000) {
+            // a millisecond deadline may wake up to a millisecond early, the remainder
+            // is then waited for on the timer file descriptor
+            return epoll_wait(_epfd, events, maxEvents, timeout < 0? -1 : int(timeout / 1000000));
+        }
+
+        if (_tmfd == INVALID_FD) {
+            _tmfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+            SUIL_ASSERT(_tmfd != INVALID_FD);
+
+            struct epoll_event tmfd{.events = EPOLLERR | EPOLLIN | EPOLLHUP, .data = {.fd = _tmfd}};
+            int rc = epoll_ctl(_epfd, EPOLL_CTL_ADD, _tmfd, &tmfd);
+            SUIL_ASSERT(rc != -1);
+        }
+
+        struct itimerspec its{.it_interval = {}, .it_value = {.tv_sec = 0, .tv_nsec = timeout}};
+        int rc = timerfd_settime(_tmfd, 0, &its, nullptr);
+        SUIL_ASSERT(rc != -1);
+        return epoll_wait(_epfd, events, maxEvents, -1);
+    }
+
     void Thread::signal()
     {
         bool expected = false;
@@ -159,6 +223,7 @@ namespace suil {
                     (handle.coro != nullptr));
 
         int op = EPOLL_CTL_ADD, ec = 0;
+        handle.owner = _id;
 
         TRY_OP:
         struct epoll_event ev {
@@ -190,11 +255,20 @@ namespace suil {
         SUIL_ASSERT((dly->_state != Delay::tsSCHEDULED) &&
                     (dly->_coro != nullptr));
         dly->_state = Delay::tsSCHEDULED;
+        dly->_owner = _id;
         dly->_timer.target = dly;
         addTimer(dly->_timer);
         record();
     }
 
+    void Thread::add(Alarm *alarm)
+    {
+        SUIL_ASSERT(alarm->_armed);
+        alarm->_owner = _id;
+        alarm->_timer.target = alarm;
+        addTimer(alarm->_timer);
+    }
+
     void Thread::schedule(std::coroutine_handle<> coro)
     {
         _scheduleQ.enqueue(coro);
@@ -238,6 +312,43 @@ namespace suil {
         }
     }
 
+    void Thread::cancel(Event *event)
+    {
+        // may be called from any thread, the coroutine is resumed on this thread
+        auto& handle = event->handle();
+        auto state = Event::esSCHEDULED;
+        if (handle.state.compare_exchange_strong(state, Event::esABANDONED)) {
+            cancelTimer(handle.timerHandle);
+            struct epoll_event ev{};
+            epoll_ctl(_epfd, EPOLL_CTL_DEL, handle.fd, &ev);
+
+            handle.state = Event::esCANCELLED;
+            _stats.inflight--;
+            schedule(handle.coro);
+        }
+    }
+
+    void Thread::cancel(Delay *dly)
+    {
+        auto state = Delay::tsSCHEDULED;
+        if (dly->_state.compare_exchange_strong(state, Delay::tsABANDONED)) {
+            cancelTimer(dly->_timer);
+            _stats.inflight--;
+            schedule(dly->_coro);
+        }
+    }
+
+    bool Thread::cancel(Alarm *alarm)
+    {
+        std::lock_guard<std::mutex> lg(_timersLock);
+        auto armed = true;
+        if (alarm->_armed.compare_exchange_strong(armed, false)) {
+            unlinkTimer(alarm->_timer);
+            return true;
+        }
+        return false;
+    }
+
     uint64 Thread::load() const
     {
         return _stats.inflight;
@@ -246,81 +357,138 @@ namespace suil {
     void Thread::addTimer(Timer& timer)
     {
         _timersLock.lock();
-        auto it = mill_list_begin(&_timers);
-        while (it) {
-            auto tm = mill_cont(it, Timer, item);
-            if (timer.dd < tm->dd)
-                break;
-            it = mill_list_next(it);
+        auto expiry = timer.expiry();
+        auto bucket = _timers.find(expiry);
+        auto created = (bucket == _timers.end());
+        if (created) {
+            if (_spareBuckets.empty()) {
+                bucket = _timers.try_emplace(expiry).first;
+            }
+            else {
+                auto node = std::move(_spareBuckets.back());
+                _spareBuckets.pop_back();
+                node.key() = expiry;
+                bucket = _timers.insert(std::move(node)).position;
+            }
+            mill_list_init(&bucket->second);
         }
-        mill_list_insert(&_timers, &timer.item, it);
+        mill_list_insert(&bucket->second, &timer.item, nullptr);
+        timer.linked = true;
+        // the wait timeout only changes if the timer expires before all others
+        auto earliest = created && (bucket == _timers.begin());
         _timersLock.unlock();
 
-        signal();
+        if (earliest) {
+            signal();
+        }
+    }
+
+    void Thread::unlinkTimer(Timer& timer)
+    {
+        // the timer might have been fired or cancelled by another thread
+        if (timer.linked) {
+            auto bucket = _timers.find(timer.expiry());
+            SUIL_ASSERT(bucket != _timers.end());
+            mill_list_erase(&bucket->second, &timer.item);
+            if (mill_list_empty(&bucket->second)) {
+                releaseBucket(bucket);
+            }
+            timer.linked = false;
+        }
+    }
+
+    void Thread::releaseBucket(TimerBuckets::iterator bucket)
+    {
+        if (_spareBuckets.size() < SUIL_ASYNC_SPARE_TIMER_BUCKETS) {
+            _spareBuckets.push_back(_timers.extract(bucket));
+        }
+        else {
+            _timers.erase(bucket);
+        }
     }
 
     void Thread::cancelTimer(Timer& handle)
     {
         std::lock_guard<std::mutex> lg(_timersLock);
-        if (handle) {
-            mill_list_erase(&_timers, &handle.item);
-        }
+        unlinkTimer(handle);
     }
 
     void Thread::fireExpiredTimers()
     {
-        auto tp = fastnow();
+        auto tp = fastnowns();
 
         _timersLock.lock();
-        while (!mill_list_empty(&_timers)) {
-            auto it = mill_cont(mill_list_begin(&_timers), Timer, item);
-            if (it == nullptr || it->dd > tp) {
+        while (!_timers.empty()) {
+            // buckets are looked up again after each timer, the lock is released
+            // while the timer's waiter runs
+            auto bucket = _timers.begin();
+            if (bucket->first > tp) {
                 break;
             }
 
-            mill_list_erase(&_timers, mill_list_begin(&_timers));
-            _timersLock.unlock();
+            auto it = mill_cont(mill_list_begin(&bucket->second), Timer, item);
+            mill_list_erase(&bucket->second, &it->item);
+            if (mill_list_empty(&bucket->second)) {
+                releaseBucket(bucket);
+            }
+            it->linked = false;
+            // claimed with the lock held, a concurrent cancel() erases the timer before
+            // resuming the waiter and therefore cannot release it under our feet
             if (holds_alternative<Event*>(it->target)) {
                 auto state = Event::esSCHEDULED;
                 auto& event = get<Event*>(it->target)->handle();
-                if (event.state.compare_exchange_weak(state, Event::esTIMEOUT)) {
+                if (event.state.compare_exchange_strong(state, Event::esTIMEOUT)) {
+                    _timersLock.unlock();
                     struct epoll_event ev{};
                     epoll_ctl(_epfd, EPOLL_CTL_DEL, event.fd, &ev);
 
                     _stats.inflight--;
                     event.coro.resume();
+                    _timersLock.lock();
                 }
             }
             else if (holds_alternative<Delay*>(it->target)) {
                 auto& timer = *get<Delay*>(it->target);
                 auto state = Delay::tsSCHEDULED;
-                if (timer._state.compare_exchange_weak(state, Delay::tsFIRED)) {
+                if (timer._state.compare_exchange_strong(state, Delay::tsFIRED)) {
+                    _timersLock.unlock();
                     _stats.inflight--;
                     timer._coro.resume();
+                    _timersLock.lock();
+                }
+            }
+            else if (holds_alternative<Alarm*>(it->target)) {
+                auto& alarm = *get<Alarm*>(it->target);
+                auto armed = true;
+                if (alarm._armed.compare_exchange_strong(armed, false)) {
+                    alarm._running = true;
+                    _timersLock.unlock();
+                    alarm._callback();
+                    // the alarm may be released once the callback returned
+                    alarm._running = false;
+                    _timersLock.lock();
                 }
             }
             else {
                 SUIL_ASSERT(false);
             }
-            _timersLock.lock();
         }
         _timersLock.unlock();
     }
 
-    int Thread::computeWaitTimeout()
+    int64 Thread::computeWaitTimeout()
     {
         std::lock_guard<std::mutex> lg{_timersLock};
 
-        if (!mill_list_begin(&_timers)) {
+        if (_timers.empty()) {
             return -1;
         }
 
-        auto tm = mill_cont(mill_list_begin(&_timers), Timer, item);
-        auto at =  tm->dd - fastnow();
+        auto at =  _timers.begin()->first - fastnowns();
         if (at <= 0) {
             return 0;
         }
-        return int(at);
+        return at;
     }
 
     Thread::Stats Thread::getStats() const
@@ -0,0 +1,382 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-21
+ */
+
+#include "suil/async/udp.hpp"
+#include "suil/async/fdwait.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+
+namespace {
+
+    void udptune(int s, bool reuseAddr) noexcept
+    {
+        SUIL_ASSERT(s >= 0);
+
+        int opt = fcntl(s, F_GETFL, 0);
+        if (opt == -1) {
+            opt = 0;
+        }
+
+        int rc = fcntl(s, F_SETFL, opt | O_NONBLOCK);
+        SUIL_ASSERT(rc != -1);
+
+        if (reuseAddr) {
+            // allow multiple receivers on the same multicast group/port
+            opt = 1;
+            rc = setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof (opt));
+            SUIL_ASSERT(rc == 0);
+        }
+    }
+
+    constexpr std::size_t GRO_CONTROL_SIZE = CMSG_SPACE(sizeof(int));
+
+    uint16 groSegmentSize(struct msghdr& hdr)
+    {
+        for (auto cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                int size;
+                memcpy(&size, CMSG_DATA(cmsg), sizeof(size));
+                return uint16(size);
+            }
+        }
+        return 0;
+    }
+
+    /**
+     * Send at most SUIL_ASYNC_UDP_MAX_BATCH datagrams in a single system call,
+     * the message headers are kept off the coroutine frame
+     */
+    int sendBatch(int fd, std::span<suil::Datagram> dgrams)
+    {
+        struct mmsghdr msgs[SUIL_ASYNC_UDP_MAX_BATCH];
+        struct iovec iovs[SUIL_ASYNC_UDP_MAX_BATCH];
+
+        auto count = std::min<std::size_t>(dgrams.size(), SUIL_ASYNC_UDP_MAX_BATCH);
+        for (auto i = 0u; i < count; i++) {
+            auto& dg = dgrams[i];
+            iovs[i] = {dg.buf.data(), dg.buf.size()};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            if (dg.addr) {
+                msgs[i].msg_hdr.msg_name = const_cast<void *>(dg.addr.raw());
+                msgs[i].msg_hdr.msg_namelen = dg.addr.size();
+            }
+        }
+
+        int rc = ::sendmmsg(fd, msgs, count, MSG_NOSIGNAL);
+        for (auto i = 0; i < rc; i++) {
+            dgrams[i].size = msgs[i].msg_len;
+        }
+        return rc;
+    }
+
+    int receiveBatch(int fd, std::span<suil::Datagram> dgrams, bool gro)
+    {
+        struct mmsghdr msgs[SUIL_ASYNC_UDP_MAX_BATCH];
+        struct iovec iovs[SUIL_ASYNC_UDP_MAX_BATCH];
+        char control[SUIL_ASYNC_UDP_MAX_BATCH][GRO_CONTROL_SIZE];
+
+        auto count = std::min<std::size_t>(dgrams.size(), SUIL_ASYNC_UDP_MAX_BATCH);
+        for (auto i = 0u; i < count; i++) {
+            auto& dg = dgrams[i];
+            iovs[i] = {dg.buf.data(), dg.buf.size()};
+            msgs[i] = {};
+            msgs[i].msg_hdr.msg_iov = &iovs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+            msgs[i].msg_hdr.msg_name = const_cast<void *>(dg.addr.raw());
+            msgs[i].msg_hdr.msg_namelen = suil::SocketAddress::MAX_IP_ADDRESS_SIZE;
+            if (gro) {
+                msgs[i].msg_hdr.msg_control = control[i];
+                msgs[i].msg_hdr.msg_controllen = GRO_CONTROL_SIZE;
+            }
+        }
+
+        int rc = ::recvmmsg(fd, msgs, count, 0, nullptr);
+        for (auto i = 0; i < rc; i++) {
+            dgrams[i].size = msgs[i].msg_len;
+            dgrams[i].segmentSize = gro? groSegmentSize(msgs[i].msg_hdr) : 0;
+            dgrams[i].truncated = (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0;
+        }
+        return rc;
+    }
+}
+
+namespace suil {
+
+    UdpSocket::UdpSocket(int fd, int err, uint16 tId)
+        : Socket(fd, err)
+    {
+        bindToThread(tId);
+    }
+
+    UdpSocket::UdpSocket(UdpSocket &&other) noexcept
+        : Socket(std::move(other)),
+          _gro{std::exchange(other._gro, false)}
+    {}
+
+    UdpSocket &UdpSocket::operator=(UdpSocket &&other) noexcept
+    {
+        if (this != std::addressof(other)) {
+            _gro = std::exchange(other._gro, false);
+            Socket::operator=(std::move(other));
+        }
+        return *this;
+    }
+
+    UdpSocket UdpSocket::bind(const SocketAddress& addr, uint16 tId, bool reuseAddr)
+    {
+        int s = socket(addr.family(), SOCK_DGRAM, 0);
+        if (s == -1) {
+            return UdpSocket{INVALID_FD, errno, tId};
+        }
+
+        udptune(s, reuseAddr);
+
+        int rc = ::bind(s, (struct sockaddr*) addr.raw(), addr.size());
+        if (rc != 0) {
+            int err = errno;
+            ::close(s);
+            errno = err;
+            return UdpSocket{INVALID_FD, err, tId};
+        }
+
+        errno = 0;
+        return UdpSocket{s, 0, tId};
+    }
+
+    int UdpSocket::connect(const SocketAddress& peer)
+    {
+        int rc = ::connect(_fd, (struct sockaddr*) peer.raw(), peer.size());
+        if (rc != 0) {
+            _error = int16(errno);
+        }
+        return rc;
+    }
+
+    auto UdpSocket::sendTo(const SocketAddress& to, const void *buf, std::size_t size,
+                           milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        auto deadline = afterd(timeout);
+        ssize_t nSent{0};
+        do {
+            nSent = ::sendto(_fd, buf, size, MSG_NOSIGNAL, (struct sockaddr*) to.raw(), to.size());
+            if (nSent < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    _error = int16(errno);
+                    break;
+                }
+
+                auto ev = co_await fdwait(_fd, Event::OUT, deadline, _slack, token, _tID);
+                if (ev != Event::esFIRED) {
+                    _error = waitError(ev);
+                    break;
+                }
+
+                continue;
+            }
+            break;
+        } while (true);
+
+        co_return int(nSent);
+    }
+
+    auto UdpSocket::receiveFrom(void *buf, std::size_t size, SocketAddress& from,
+                                milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        auto deadline = afterd(timeout);
+        ssize_t nReceived{0};
+        do {
+            socklen_t addrlen = SocketAddress::MAX_IP_ADDRESS_SIZE;
+            // MSG_TRUNC returns the real size of the datagram so that truncation can be detected
+            nReceived = ::recvfrom(_fd, buf, size, MSG_TRUNC, (struct sockaddr*) from._data, &addrlen);
+            if (nReceived < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    _error = int16(errno);
+                    break;
+                }
+
+                auto ev = co_await fdwait(_fd, Event::IN, deadline, _slack, token, _tID);
+                if (ev != Event::esFIRED) {
+                    _error = waitError(ev);
+                    break;
+                }
+
+                continue;
+            }
+            if (std::size_t(nReceived) > size) {
+                _error = EMSGSIZE;
+                nReceived = ssize_t(size);
+            }
+            break;
+        } while (true);
+
+        co_return int(nReceived);
+    }
+
+    auto UdpSocket::sendMany(std::span<Datagram> dgrams, milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        auto deadline = afterd(timeout);
+        std::size_t nSent{0};
+        while (nSent < dgrams.size()) {
+            int rc = sendBatch(_fd, dgrams.subspan(nSent));
+            if (rc > 0) {
+                nSent += rc;
+                continue;
+            }
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _error = int16(errno);
+                break;
+            }
+
+            auto ev = co_await fdwait(_fd, Event::OUT, deadline, _slack, token, _tID);
+            if (ev != Event::esFIRED) {
+                _error = waitError(ev);
+                break;
+            }
+        }
+
+        co_return (nSent == 0 && !dgrams.empty())? -1 : int(nSent);
+    }
+
+    auto UdpSocket::receiveMany(std::span<Datagram> dgrams, milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        auto deadline = afterd(timeout);
+        int nReceived{0};
+        do {
+            nReceived = receiveBatch(_fd, dgrams, _gro);
+            if (nReceived < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    _error = int16(errno);
+                    break;
+                }
+
+                auto ev = co_await fdwait(_fd, Event::IN, deadline, _slack, token, _tID);
+                if (ev != Event::esFIRED) {
+                    _error = waitError(ev);
+                    break;
+                }
+
+                continue;
+            }
+            break;
+        } while (true);
+
+        co_return nReceived;
+    }
+
+    bool UdpSocket::setSegmentSize(uint16 size)
+    {
+        int opt = size;
+        if (setsockopt(_fd, SOL_UDP, UDP_SEGMENT, &opt, sizeof(opt)) != 0) {
+            _error = int16(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool UdpSocket::enableGro(bool on)
+    {
+        int opt = on;
+        if (setsockopt(_fd, SOL_UDP, UDP_GRO, &opt, sizeof(opt)) != 0) {
+            _error = int16(errno);
+            return false;
+        }
+        _gro = on;
+        return true;
+    }
+
+    bool UdpSocket::membership(const SocketAddress& group, unsigned ifIndex, bool join)
+    {
+        int rc;
+        if (group.family() == AF_INET) {
+            struct ip_mreqn req{};
+            req.imr_multiaddr = ((struct sockaddr_in *) group.raw())->sin_addr;
+            req.imr_address.s_addr = htonl(INADDR_ANY);
+            req.imr_ifindex = int(ifIndex);
+            rc = setsockopt(_fd, IPPROTO_IP, join? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP, &req, sizeof(req));
+        }
+        else if (group.family() == AF_INET6) {
+            struct ipv6_mreq req{};
+            req.ipv6mr_multiaddr = ((struct sockaddr_in6 *) group.raw())->sin6_addr;
+            req.ipv6mr_interface = ifIndex;
+            rc = setsockopt(_fd, IPPROTO_IPV6, join? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP, &req, sizeof(req));
+        }
+        else {
+            errno = EAFNOSUPPORT;
+            rc = -1;
+        }
+
+        if (rc != 0) {
+            _error = int16(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool UdpSocket::joinGroup(const SocketAddress& group, unsigned ifIndex)
+    {
+        return membership(group, ifIndex, true);
+    }
+
+    bool UdpSocket::leaveGroup(const SocketAddress& group, unsigned ifIndex)
+    {
+        return membership(group, ifIndex, false);
+    }
+
+    bool UdpSocket::setMulticastLoop(bool on)
+    {
+        int opt = on;
+        int rc = isIpv6()?
+                 setsockopt(_fd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &opt, sizeof(opt)) :
+                 setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_LOOP, &opt, sizeof(opt));
+        if (rc != 0) {
+            _error = int16(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool UdpSocket::setMulticastTtl(int ttl)
+    {
+        int rc = isIpv6()?
+                 setsockopt(_fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &ttl, sizeof(ttl)) :
+                 setsockopt(_fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        if (rc != 0) {
+            _error = int16(errno);
+            return false;
+        }
+        return true;
+    }
+
+    bool UdpSocket::isIpv6() const
+    {
+        int domain{AF_UNSPEC};
+        socklen_t len = sizeof(domain);
+        getsockopt(_fd, SOL_SOCKET, SO_DOMAIN, &domain, &len);
+        return domain == AF_INET6;
+    }
+}
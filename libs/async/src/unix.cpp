@@ -0,0 +1,391 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-21
+ */
+
+#include "suil/async/unix.hpp"
+#include "suil/async/fdwait.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+namespace {
+
+    void unixtune(int s) noexcept
+    {
+        SUIL_ASSERT(s >= 0);
+
+        int opt = fcntl(s, F_GETFL, 0);
+        if (opt == -1) {
+            opt = 0;
+        }
+
+        int rc = fcntl(s, F_SETFL, opt | O_NONBLOCK);
+        SUIL_ASSERT(rc != -1);
+    }
+
+    int sockType(suil::UnixSocket::Type type)
+    {
+        return (type == suil::UnixSocket::SEQPACKET? SOCK_SEQPACKET : SOCK_STREAM) | SOCK_CLOEXEC;
+    }
+}
+
+namespace suil {
+
+    UnixSocket::UnixSocket(int fd, int err, uint16 tId)
+        : Socket(fd, err)
+    {
+        bindToThread(tId);
+    }
+
+    UnixSocket::UnixSocket(UnixSocket &&other) noexcept
+        : Socket(std::move(other)),
+          _address{other._address}
+    {}
+
+    UnixSocket &UnixSocket::operator=(UnixSocket &&other) noexcept
+    {
+        if (this != std::addressof(other)) {
+            _address = other._address;
+            Socket::operator=(std::move(other));
+        }
+        return *this;
+    }
+
+    Task<UnixSocket> UnixSocket::connect(const SocketAddress& addr, Type type, uint16 queueID, milliseconds timeout)
+    {
+        if (addr.family() != AF_UNIX) {
+            errno = EAFNOSUPPORT;
+            co_return UnixSocket{INVALID_FD, errno, queueID};
+        }
+
+        int s = socket(AF_UNIX, sockType(type), 0);
+        if (s == -1) {
+            co_return UnixSocket{INVALID_FD, errno, queueID};
+        }
+
+        unixtune(s);
+
+        auto dd = afterd(timeout);
+        int rc = ::connect(s, (struct sockaddr*) addr._data, addr.size());
+        int64 backoff{1};
+        while (rc != 0 && errno == EAGAIN) {
+            // the listener's backlog is full and no connection is pending, the socket
+            // cannot be waited on, retry until there is room or the deadline expires
+            auto left = dd < 0? backoff : dd - fastnow();
+            if (left <= 0) {
+                ::close(s);
+                errno = ETIMEDOUT;
+                co_return UnixSocket{INVALID_FD, ETIMEDOUT, queueID};
+            }
+
+            co_await Delay{std::min(backoff, left), queueID};
+            backoff = std::min<int64>(backoff * 2, 64);
+            rc = ::connect(s, (struct sockaddr*) addr._data, addr.size());
+        }
+
+        if (rc != 0) {
+            SUIL_ASSERT(rc == -1);
+            if(errno != EINPROGRESS) {
+                int err = errno;
+                ::close(s);
+                co_return UnixSocket{INVALID_FD, err, queueID};
+            }
+
+            auto ev = co_await fdwait(s, Event::OUT, dd, queueID);
+            if (ev != Event::esFIRED) {
+                int err = ev == Event::esTIMEOUT? ETIMEDOUT : errno;
+                ::close(s);
+                errno = err;
+                co_return UnixSocket{INVALID_FD, err, queueID};
+            }
+
+            int err{0};
+            socklen_t errsz = sizeof(err);
+            rc = getsockopt(s, SOL_SOCKET, SO_ERROR, (void*)&err, &errsz);
+            if (rc != 0 || err != 0) {
+                err = rc != 0? errno : err;
+                ::close(s);
+                errno = err;
+                co_return UnixSocket{INVALID_FD, err, queueID};
+            }
+        }
+
+        errno = 0;
+        UnixSocket sock{s, 0, queueID};
+        sock._address = addr;
+        co_return sock;
+    }
+
+    Task<UnixSocket> UnixSocket::connect(const SocketAddress& addr, Type type, milliseconds timeout)
+    {
+        return connect(addr, type, THREAD_ID_ANY, timeout);
+    }
+
+    std::pair<UnixSocket, UnixSocket> UnixSocket::pair(Type type, uint16 tId)
+    {
+        int fds[2];
+        if (socketpair(AF_UNIX, sockType(type), 0, fds) != 0) {
+            int err = errno;
+            return {UnixSocket{INVALID_FD, err, tId}, UnixSocket{INVALID_FD, err, tId}};
+        }
+
+        unixtune(fds[0]);
+        unixtune(fds[1]);
+        errno = 0;
+        return {UnixSocket{fds[0], 0, tId}, UnixSocket{fds[1], 0, tId}};
+    }
+
+    auto UnixSocket::sendFds(std::span<const int> fds, const void *buf, std::size_t size,
+                             milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        if (fds.size() > SUIL_ASYNC_UNIX_MAX_FDS) {
+            _error = errno = EINVAL;
+            co_return -1;
+        }
+
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * SUIL_ASYNC_UNIX_MAX_FDS)];
+        struct iovec iov{const_cast<void *>(buf), size};
+        struct msghdr msg{};
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        if (!fds.empty()) {
+            msg.msg_control = control;
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * fds.size());
+            auto cmsg = CMSG_FIRSTHDR(&msg);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fds.size());
+            memcpy(CMSG_DATA(cmsg), fds.data(), sizeof(int) * fds.size());
+        }
+
+        auto deadline = afterd(timeout);
+        ssize_t nSent{0};
+        do {
+            nSent = ::sendmsg(_fd, &msg, MSG_NOSIGNAL);
+            if (nSent < 0) {
+                if (errno == EPIPE) {
+                    _error = errno = ECONNRESET;
+                    break;
+                }
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    _error = int16(errno);
+                    break;
+                }
+
+                auto ev = co_await fdwait(_fd, Event::OUT, deadline, _slack, token, _tID);
+                if (ev != Event::esFIRED) {
+                    _error = waitError(ev);
+                    break;
+                }
+
+                continue;
+            }
+            break;
+        } while (true);
+
+        co_return int(nSent);
+    }
+
+    auto UnixSocket::sendFds(std::span<const int> fds, milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        static const char Tag{'\0'};
+        return sendFds(fds, &Tag, sizeof(Tag), timeout, std::move(token));
+    }
+
+    auto UnixSocket::recvFds(std::span<int> fds, void *buf, std::size_t size,
+                             milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int) * SUIL_ASYNC_UNIX_MAX_FDS)];
+        auto deadline = afterd(timeout);
+        ssize_t nReceived{0};
+        struct msghdr msg{};
+        struct iovec iov{buf, size};
+        do {
+            msg = {};
+            msg.msg_iov = &iov;
+            msg.msg_iovlen = 1;
+            msg.msg_control = control;
+            msg.msg_controllen = CMSG_SPACE(sizeof(int) * std::min<std::size_t>(fds.size(), SUIL_ASYNC_UNIX_MAX_FDS));
+
+            nReceived = ::recvmsg(_fd, &msg, MSG_CMSG_CLOEXEC);
+            if (nReceived < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                    _error = int16(errno);
+                    break;
+                }
+
+                auto ev = co_await fdwait(_fd, Event::IN, deadline, _slack, token, _tID);
+                if (ev != Event::esFIRED) {
+                    _error = waitError(ev);
+                    break;
+                }
+
+                continue;
+            }
+            else if (nReceived == 0) {
+                _error = errno = ECONNRESET;
+            }
+            break;
+        } while (true);
+
+        std::size_t nFds{0};
+        if (nReceived > 0) {
+            for (auto cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) {
+                    continue;
+                }
+
+                auto count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (auto i = 0u; i < count; i++) {
+                    int fd;
+                    memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(int));
+                    if (nFds < fds.size()) {
+                        fds[nFds++] = fd;
+                    }
+                    else {
+                        ::close(fd);
+                    }
+                }
+            }
+        }
+
+        for (auto i = nFds; i < fds.size(); i++) {
+            fds[i] = INVALID_FD;
+        }
+
+        co_return int(nReceived);
+    }
+
+    auto UnixSocket::recvFds(std::span<int> fds, milliseconds timeout, CancellationToken token) -> Task<int>
+    {
+        char tag{0};
+        co_return co_await recvFds(fds, &tag, sizeof(tag), timeout, std::move(token));
+    }
+
+    void UnixSocket::close() noexcept
+    {
+        if (isValid()) {
+            Socket::close();
+            _address = {};
+        }
+    }
+
+    int UnixSocket::detach()
+    {
+        if (isValid()) {
+            _address = {};
+        }
+        return Socket::detach();
+    }
+
+    UnixListener::~UnixListener() noexcept
+    {
+        this->close();
+    }
+
+    UnixListener::UnixListener(UnixListener &&other) noexcept
+        : _fd{std::exchange(other._fd, INVALID_FD)},
+          _address{std::exchange(other._address, {})},
+          _error{std::exchange(other._error, 0)}
+    {}
+
+    UnixListener &UnixListener::operator=(UnixListener &&other) noexcept
+    {
+        if (this != std::addressof(other)) {
+            close();
+            _fd = std::exchange(other._fd, INVALID_FD);
+            _address = std::exchange(other._address, {});
+            _error = std::exchange(other._error, 0);
+        }
+        return *this;
+    }
+
+    void UnixListener::close()
+    {
+        if (_fd != INVALID_FD) {
+            ::shutdown(_fd, SHUT_RDWR);
+            ::close(_fd);
+            _fd = INVALID_FD;
+
+            auto un = (const struct sockaddr_un *) _address.raw();
+            if (un->sun_family == AF_UNIX && un->sun_path[0] != '\0') {
+                ::unlink(un->sun_path);
+            }
+            _address = {};
+        }
+    }
+
+    auto UnixListener::acceptOn(uint16 tId, std::chrono::milliseconds timeout) -> Task<UnixSocket>
+    {
+        socklen_t addrlen;
+        UnixSocket sock{};
+        auto dd = afterd(timeout);
+        while (true) {
+            addrlen = SocketAddress::MAX_ADDRESS_SIZE;
+            int as = ::accept4(_fd, (struct sockaddr *) sock._address._data, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (as >= 0) {
+                sock._fd = as;
+                sock.bindToThread(tId);
+                _error = errno = 0;
+                break;
+            }
+
+            SUIL_ASSERT(as == -1);
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                _error = errno;
+                break;
+            }
+
+            auto rc = co_await  fdwait(_fd, Event::IN, dd, tId);
+            if (rc != Event::esFIRED) {
+                _error = rc == Event::esTIMEOUT? ETIMEDOUT : errno;
+                break;
+            }
+        }
+
+        co_return sock;
+    }
+
+    UnixListener UnixListener::listen(const SocketAddress &addr, int backlog, UnixSocket::Type type)
+    {
+        if (addr.family() != AF_UNIX) {
+            errno = EAFNOSUPPORT;
+            return {INVALID_FD, {}, errno};
+        }
+
+        int s = socket(AF_UNIX, sockType(type), 0);
+        if (s == -1) {
+            return {INVALID_FD, {}, errno};
+        }
+        unixtune(s);
+
+        int rc = bind(s, (struct sockaddr*) addr.raw(), addr.size());
+        if (rc != 0) {
+            int err = errno;
+            ::close(s);
+            errno = err;
+            return {INVALID_FD, {}, err};
+        }
+
+        rc = ::listen(s, backlog);
+        if (rc != 0) {
+            int err = errno;
+            ::close(s);
+            errno = err;
+            return {INVALID_FD, {}, err};
+        }
+
+        errno = 0;
+        return UnixListener{s, addr};
+    }
+}
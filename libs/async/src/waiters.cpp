@@ -0,0 +1,72 @@
+/**
+ * Copyright (c) 2022 Suilteam, Carter Mbotho
+ *
+ * This library is free software; you can redistribute it and/or modify it
+ * under the terms of the MIT license. See LICENSE for details.
+ *
+ * @author Carter
+ * @date 2022-03-25
+ */
+
+#include "suil/async/detail/waiters.hpp"
+#include "suil/async/scheduler.hpp"
+
+namespace suil::detail {
+
+    void intrusive_waiter::resume()
+    {
+        Scheduler::instance().schedule(coro, tid);
+    }
+
+    void wait_queue::park(timed_waiter& w, std::coroutine_handle<> coro, int64 dd)
+    {
+        auto id = qid();
+        w.coro = coro;
+        w.tid = id < 0? THREAD_ID_ANY : uint16(id);
+        w.since = fastnow();
+        w.granted = false;
+        push(&w);
+        stats.waited++;
+
+        if (dd >= 0) {
+            // the timer is scheduled with the owner's lock held, grant() therefore always finds it scheduled
+            w.timer.emplace(std::max<int64>(dd - w.since, 0), w.tid);
+            w.timer->await_suspend(coro);
+        }
+    }
+
+    void wait_queue::grant()
+    {
+        auto w = head;
+        SUIL_ASSERT(w != nullptr);
+        remove(w);
+        w->granted = true;
+
+        auto waited = uint64(std::max<int64>(fastnow() - w->since, 0));
+        stats.totalWaitMs += waited;
+        stats.maxWaitMs = std::max(stats.maxWaitMs, waited);
+
+        if (w->timer) {
+            // has no effect if the timer just expired, the waiter will find that it was granted
+            Scheduler::instance().cancel(&*w->timer);
+        }
+        else {
+            Scheduler::instance().schedule(w->coro, w->tid);
+        }
+    }
+
+    bool wait_queue::resumed(timed_waiter& w)
+    {
+        if (w.timer) {
+            w.timer->await_resume();
+            w.timer.reset();
+        }
+
+        if (!w.granted) {
+            // timed out
+            remove(&w);
+            stats.timedOut++;
+        }
+        return w.granted;
+    }
+}
@@ -190,8 +190,21 @@ namespace suil {
 
     int64_t afterd(milliseconds timeout = DELAY_INF);
 
+    /**
+     * @return the absolute deadline in nanoseconds (see fastnowns()) after the given
+     * timeout, -1 if the timeout is not positive
+     */
+    int64_t afterdns(nanoseconds timeout);
+
     int64_t fastnow();
 
+    /**
+     * @return the monotonic time in nanoseconds, on the same time base as fastnow().
+     * Extrapolated from the CPU's timestamp counter when it is invariant, otherwise
+     * read from the OS clock.
+     */
+    int64_t fastnowns();
+
     constexpr int INVALID_FD{-1};
 
     template<typename T>
@@ -14,63 +14,123 @@
 #include <fcntl.h>
 #include <openssl/rand.h>
 
-/* 1 millisecond expressed in CPU ticks. The value is chosen is such a way that
-   it works reasonably well for CPU frequencies above 500MHz. On significanly
-   slower machines you may wish to reconsider. */
-#define MILL_CLOCK_PRECISION 1000000
+#if (defined __GNUC__ || defined __clang__) && \
+      (defined __i386__ || defined __x86_64__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#define SUIL_HAS_TSC 1
+#endif
+
+#ifndef SUIL_TSC_CALIBRATION_NS
+// how long the TSC frequency is measured against the OS clock on first use
+#define SUIL_TSC_CALIBRATION_NS 2000000
+#endif
 
+#ifndef SUIL_TSC_ANCHOR_NS
+// how often each thread re-reads the OS clock, bounds the drift of the TSC clock
+#define SUIL_TSC_ANCHOR_NS 10000000
+#endif
 
 namespace {
 
-    int64_t mill_os_time() {
+    int64_t mill_os_time_ns() {
 #if defined __APPLE__
         if (mill_slow(!mill_mtid.denom))
         mach_timebase_info(&mill_mtid);
         uint64_t ticks = mach_absolute_time();
-        return (int64_t)(ticks * mill_mtid.numer / mill_mtid.denom / 1000000);
+        return (int64_t)(ticks * mill_mtid.numer / mill_mtid.denom);
 #elif defined CLOCK_MONOTONIC
         timespec ts{};
         int rc = clock_gettime(CLOCK_MONOTONIC, &ts);
         SUIL_ASSERT(rc == 0);
-        return ((int64_t)ts.tv_sec) * 1000 + (((int64_t)ts.tv_nsec) / 1000000);
+        return ((int64_t)ts.tv_sec) * 1000000000 + (int64_t)ts.tv_nsec;
 #else
         struct timeval tv;
         int rc = gettimeofday(&tv, NULL);
         assert(rc == 0);
-        return ((int64_t)tv.tv_sec) * 1000 + (((int64_t)tv.tv_usec) / 1000);
+        return ((int64_t)tv.tv_sec) * 1000000000 + (((int64_t)tv.tv_usec) * 1000);
 #endif
     }
 
-    inline int64_t mill_now_() {
-#if (defined __GNUC__ || defined __clang__) && \
-      (defined __i386__ || defined __x86_64__)
-        /* Get the timestamp counter. This is time since startup, expressed in CPU
-           cycles. Unlike gettimeofday() or similar function, it's extremely fast -
-           it takes only few CPU cycles to evaluate. */
-        uint32_t low;
-        uint32_t high;
-        __asm__ volatile("rdtsc" : "=a" (low), "=d" (high));
-        auto tsc = (int64_t)((uint64_t)high << 32 | low);
-        /* These global variables are used to hold the last seen timestamp counter
-           and last seen time measurement. We'll initilise them the first time
-           this function is called. */
-        static __thread int64_t last_tsc = -1;
-        static __thread int64_t last_now = -1;
-        if(unlikely(last_tsc < 0)) {
-            last_tsc = tsc;
-            last_now = mill_os_time();
+#ifdef SUIL_HAS_TSC
+    /* The timestamp counter can only be used as a clock if it ticks at a constant
+       rate regardless of the CPU's power state, which CPUs advertise as an
+       invariant TSC. Its rate is measured against the OS clock once. */
+    struct tsc_clock {
+        static void sample(uint64_t& tsc, int64_t& ns) {
+            // pair the counter with the OS clock, retrying if the thread was interrupted in between
+            uint64_t window{UINT64_MAX};
+            for (int i = 0; i < 4; i++) {
+                auto before = __rdtsc();
+                auto now = mill_os_time_ns();
+                auto after = __rdtsc();
+                if (after >= before && after - before < window) {
+                    window = after - before;
+                    tsc = before + window / 2;
+                    ns = now;
+                }
+            }
         }
-        /* If TSC haven't jumped back or progressed more than 1/2 ms, we can use
-           the cached time value. */
-        if(likely(tsc - last_tsc <= (MILL_CLOCK_PRECISION / 2) && tsc >= last_tsc))
-            return last_now;
-        /* It's more than 1/2 ms since we've last measured the time.
-           We'll do a new measurement now. */
-        last_tsc = tsc;
-        last_now = mill_os_time();
-        return last_now;
+
+        tsc_clock() {
+            unsigned eax{0}, ebx{0}, ecx{0}, edx{0};
+            if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) || !(edx & (1u << 8))) {
+                return;
+            }
+
+            uint64_t tsc0{0}, tsc1{0};
+            int64_t ns0{0}, ns1{0};
+            sample(tsc0, ns0);
+            do {
+                sample(tsc1, ns1);
+            } while (ns1 - ns0 < SUIL_TSC_CALIBRATION_NS);
+            if (tsc1 <= tsc0) {
+                return;
+            }
+
+            // nanoseconds per tick in 32.32 fixed point
+            mult = (uint64_t(ns1 - ns0) << 32) / (tsc1 - tsc0);
+            // ticks after which a thread re-anchors, keeps the product below 2^64
+            period = std::max<uint64_t>((tsc1 - tsc0) * SUIL_TSC_ANCHOR_NS / uint64_t(ns1 - ns0), 1);
+            usable = mult != 0;
+        }
+
+        uint64_t mult{0};
+        uint64_t period{0};
+        bool usable{false};
+    };
+
+    const tsc_clock& tscClock() {
+        static const tsc_clock clock{};
+        return clock;
+    }
+#endif
+
+    inline int64_t mill_now_ns_() {
+#ifdef SUIL_HAS_TSC
+        /* Reading the timestamp counter takes a few CPU cycles, much cheaper than
+           asking the OS. Each thread anchors the counter to the OS clock and
+           extrapolates from the anchor until it gets too old. */
+        static __thread uint64_t anchor_tsc{0};
+        static __thread int64_t anchor_ns{-1};
+        static __thread int64_t last_ns{0};
+        auto& clock = tscClock();
+        if (unlikely(!clock.usable)) {
+            return mill_os_time_ns();
+        }
+
+        uint64_t tsc = __rdtsc();
+        if (unlikely(anchor_ns < 0 || tsc < anchor_tsc || tsc - anchor_tsc >= clock.period)) {
+            tsc_clock::sample(anchor_tsc, anchor_ns);
+            tsc = std::max(tsc, anchor_tsc);
+        }
+
+        auto now = anchor_ns + int64_t(((tsc - anchor_tsc) * clock.mult) >> 32);
+        // re-anchoring must not step the thread's clock back
+        last_ns = std::max(last_ns, now);
+        return last_ns;
 #else
-        return mill_os_time();
+        return mill_os_time_ns();
 #endif
     }
 
@@ -297,10 +357,18 @@ namespace suil {
     int64_t afterd(milliseconds timeout)
     {
         auto ms = timeout.count();
-        return ms <= 0? -1: mill_now_() + timeout.count();
+        return ms <= 0? -1: fastnow() + timeout.count();
     }
 
-    int64_t fastnow() { return mill_now_(); }
+    int64_t afterdns(nanoseconds timeout)
+    {
+        auto ns = timeout.count();
+        return ns <= 0? -1: mill_now_ns_() + ns;
+    }
+
+    int64_t fastnow() { return mill_now_ns_() / 1000000; }
+
+    int64_t fastnowns() { return mill_now_ns_(); }
 }
 
 #ifdef SUIL_UNITTEST
@@ -507,4 +575,37 @@ TEST_CASE("String API's on std::string/std::string_view", "[trim][parts][split]"
     }
 }
 
+TEST_CASE("Monotonic time", "[fastnow][fastnowns][afterdns]")
+{
+    SECTION("nanosecond time base", "[fastnowns]") {
+        auto ns = suil::fastnowns();
+        auto ms = suil::fastnow();
+        // both clocks share the same time base
+        REQUIRE(std::abs(ms - ns / 1000000) <= 1);
+
+        auto last = ns;
+        for (int i = 0; i < 100000; i++) {
+            auto now = suil::fastnowns();
+            REQUIRE(now >= last);
+            last = now;
+        }
+    }
+
+    SECTION("nanosecond precision", "[fastnowns]") {
+        auto start = suil::fastnowns();
+        std::this_thread::sleep_for(std::chrono::microseconds{200});
+        auto elapsed = suil::fastnowns() - start;
+        REQUIRE(elapsed >= 200000);
+        REQUIRE(elapsed < 50000000);
+    }
+
+    SECTION("deadlines", "[afterdns]") {
+        REQUIRE(suil::afterdns(suil::nanoseconds{0}) == -1);
+        REQUIRE(suil::afterdns(suil::nanoseconds{-5}) == -1);
+        auto now = suil::fastnowns();
+        auto dd = suil::afterdns(suil::microseconds{500});
+        REQUIRE(dd >= now + 500000);
+    }
+}
+
 #endif